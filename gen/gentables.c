@@ -0,0 +1,57 @@
+/*
+ * Generate the neighbour and jump tables used by the move generator.
+ *
+ * For every square of the bitboard layout and every direction, the tables
+ * give the square index of the adjacent cell and of the cell on which a
+ * jump over that adjacent cell lands.  Squares that are not on the playing
+ * area map to OFFBOARD, a square that is never occupied and never open, so
+ * that the generator needs no bounds checks.  The output is a C header,
+ * written to stdout.
+ */
+
+#include <stdio.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+int rdirect[] = { 0, -1, -1,  0,  1,  1 };
+int cdirect[] = { 1,  1,  0, -1, -1,  0 };
+
+static int on_board(int r, int c)
+{
+    return r >= 0 && r < BDSIZE && c >= 0 && c < BDSIZE;
+}
+
+/* Square reached by k steps in direction d from (r, c), or OFFBOARD. */
+static int target(int r, int c, int d, int k)
+{
+    int tr = r + k * rdirect[d], tc = c + k * cdirect[d];
+
+    if (!on_board(r, c) || !on_board(tr, tc))
+        return OFFBOARD;
+    return SQUARE(tr, tc);
+}
+
+static void print_table(const char *name, int k)
+{
+    printf("static const unsigned char %s[NSQUARES][NDIRS] = {\n", name);
+    for (int s = 0; s < NSQUARES; s++) {
+        printf("    {");
+        for (int d = 0; d < NDIRS; d++)
+            printf("%s%3d", d ? ", " : " ", target(SQ_ROW(s), SQ_COL(s), d, k));
+        printf(" },\n");
+    }
+    printf("};\n");
+}
+
+int main(void)
+{
+    printf("/* Generated by gen/gentables.c -- do not edit. */\n\n");
+    printf("#ifndef TABLES_H\n#define TABLES_H\n\n");
+    printf("/* Adjacent square in each direction. */\n");
+    print_table("neighbor", 1);
+    printf("\n/* Landing square of a jump in each direction. */\n");
+    print_table("landing", 2);
+    printf("\n#endif /* TABLES_H */\n");
+    return 0;
+}
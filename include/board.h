@@ -0,0 +1,690 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+/*
+ * Internal interface to the game board, move generator and search.
+ * Everything declared here sits behind the opaque types exported by
+ * ccheck.h; main program code should only need ccheck.h.
+ */
+
+#include <signal.h>
+#include <stdint.h>
+
+#include "ccheck.h"
+
+/*
+ * The playing area is a 9x9 rhombus.  Row and column numbers (0-8) are
+ * packed into a Move as four-bit fields:
+ *
+ *      bits 12-15: row from    bits 8-11: column from
+ *      bits  4-7:  row to      bits 0-3:  column to
+ *      bit  16:    set if the move was made by O
+ *
+ * A move whose source and destination coincide is a "pass".
+ */
+#define BDSIZE 9
+#define NPIECES 10                        // Pieces per player
+#define NDIRS 6                           // Directions of movement
+#define NDIAGS (2 * BDSIZE - 1)           // Values of row + column
+#define MAXMOVES 1000                     // Capacity of a move list
+#define MAXHIST 1000                      // Capacity of the board's move log
+#define MAXGAME (MAXHIST - MAXPLY)        // Longest game, leaving room to search
+#define BDPOOL 8                          // Boards preallocated for newbd
+#define MOVE_TEXT 256                     // Longest printed move, plus NUL
+
+#define MOVE_PLAYER 0x10000               // Set in moves made by O
+#define MOVE_END 0x20000                  // Terminator for move lists
+
+#define POINT(r, c) (((r) << 4) | (c))
+#define MAKE_MOVE(p, from, to) (((p) << 16) | ((from) << 8) | (to))
+#define IS_PASS(m) (((((m) >> 8) ^ (m)) & 0xff) == 0)
+
+/*
+ * Bitboards.  Each cell of the board is one bit of a 128-bit mask, at
+ * square index (r + 1) * BBWIDTH + c.  Rows are BBWIDTH = 10 bits wide, so
+ * that column 9 of each row is a permanently empty guard cell, and one
+ * guard row lies below row 0: a step or a hop in any of the six directions
+ * from an occupied cell then stays inside the 128 bits, and never carries
+ * a piece from one edge of the board onto the opposite edge.
+ */
+typedef unsigned __int128 Bitboard;
+
+#define BBWIDTH 10
+#define SQUARE(r, c) (((r) + 1) * BBWIDTH + (c))
+#define SQ_ROW(s) ((s) / BBWIDTH - 1)
+#define SQ_COL(s) ((s) % BBWIDTH)
+#define SQ_POINT(s) POINT(SQ_ROW(s), SQ_COL(s))
+#define BIT(s) ((Bitboard)1 << (s))
+#define NSQUARES ((BDSIZE + 1) * BBWIDTH) // Square indices in use
+#define OFFBOARD 0                        // A guard square, never on the board
+
+extern Bitboard onboard;                  // All cells of the playing area
+extern Bitboard home[2];                  // Starting triangle of each player
+extern Bitboard goal[2];                  // Triangle each player must fill
+extern Bitboard swapzone[2];              // Where a step may displace an opponent
+extern Bitboard ahead[2][NDIAGS];         // Cells no further from goal than
+                                          // those with row + column = k
+
+/* Clear the lowest set bit of a bitboard and return its square index. */
+static inline int bb_pop(Bitboard *b)
+{
+    unsigned long long lo = (unsigned long long)*b;
+    int s = lo ? __builtin_ctzll(lo)
+               : 64 + __builtin_ctzll((unsigned long long)(*b >> 64));
+    *b &= *b - 1;
+    return s;
+}
+
+/* Number of set bits in a bitboard. */
+static inline int bb_count(Bitboard b)
+{
+    return __builtin_popcountll((unsigned long long)b)
+         + __builtin_popcountll((unsigned long long)(b >> 64));
+}
+
+/*
+ * The game board.  Only the two occupancy masks describe the position;
+ * the remaining fields are bookkeeping that apply and undo maintain
+ * incrementally.  In particular, the piece lists give the square of each
+ * piece, in no particular order, so that the pieces of a player can be
+ * visited without scanning the masks, and index gives the position in its
+ * player's list of the piece on each occupied square.  Fields are ordered
+ * so that copybd can copy everything up to the live part of the move log in
+ * one go.
+ */
+struct board {
+    Bitboard occ[2];                      // Cells occupied by X and by O
+    uint64_t key;                         // Zobrist key of the position
+    Player player;                        // Player to move
+    int moveno;                           // Number of the pending move
+    int progress[2];                      // Distance travelled towards goal
+    int center[2];                        // Closeness to the long diagonal
+    int hp;                               // Number of entries in history
+    unsigned char pieces[2][NPIECES];     // Square of each piece
+    unsigned char index[NSQUARES];        // List position of piece on square
+    Move history[MAXHIST];                // Moves applied, for undo
+};
+
+/*
+ * Zobrist hashing.  The key of a position is the XOR of one random word
+ * for each (player, square) that is occupied, together with zobrist_side
+ * when O is to move.
+ */
+extern uint64_t zobrist[2][128];          // Per-player, per-square keys
+extern uint64_t zobrist_side;             // Key for O to move
+
+/* Cells that are not occupied by either player. */
+static inline Bitboard empty_cells(Board *bp)
+{
+    return onboard & ~(bp->occ[X] | bp->occ[O]);
+}
+
+/* Direction tables, indexed by direction number (0-5). */
+extern int rdirect[];                     // Row increment
+extern int cdirect[];                     // Column increment
+
+/**
+ * Initialize a board in caller-provided storage, in the state corresponding
+ * to the start of a game.  This allows boards to be placed on the stack or
+ * inside other structures, without any heap allocation.
+ *
+ * @param bp  The storage to be initialized.
+ * @return  bp, for convenience.
+ */
+Board *initbd(Board *bp);
+
+/**
+ * Set up a board with the given position, which must have NPIECES pieces
+ * for each player.  The evaluation terms, the Zobrist key and the piece
+ * lists are computed from scratch; the move log is cleared and the move
+ * number is set to zero.
+ *
+ * @param bp  The board to be set up.
+ * @param xs  Cells occupied by X.
+ * @param os  Cells occupied by O.
+ * @param p  The player to move.
+ * @return  bp, for convenience.
+ */
+Board *setbd(Board *bp, Bitboard xs, Bitboard os, Player p);
+
+/**
+ * Release a board obtained from newbd.  Boards initialized in place by
+ * initbd must not be passed to this function.
+ *
+ * @param bp  The board to be released.  Nothing is done if it is NULL.
+ */
+void freebd(Board *bp);
+
+/**
+ * Get the Zobrist key of the position on a board.  Positions with the same
+ * pieces on the same cells and the same player to move have the same key,
+ * regardless of the moves by which they were reached.
+ *
+ * @param bp  The board whose key is wanted.
+ * @return  The 64-bit key, maintained incrementally by apply and undo.
+ */
+uint64_t board_key(Board *bp);
+
+/**
+ * Retract the move most recently applied to a board, restoring the state
+ * of the board to what it was before the move was applied.  Calling this
+ * function on a pristine board has no effect.
+ *
+ * @param bp  The board from which a move is to be retracted.
+ */
+void undo(Board *bp);
+
+/**
+ * Mark the current position in the move log of a board, so that it can
+ * later be restored by undo_to.
+ *
+ * @param bp  The board whose position is to be marked.
+ * @return  A mark identifying the current position.
+ */
+int checkpoint(Board *bp);
+
+/**
+ * Retract moves from a board until the position recorded by a previous call
+ * to checkpoint is reached.  This costs one undo per retracted move, rather
+ * than a copy of the whole board.
+ *
+ * @param bp  The board from which moves are to be retracted.
+ * @param mark  The value returned by checkpoint.
+ */
+void undo_to(Board *bp, int mark);
+
+/*
+ * Mirror symmetry.  Reflecting the board in the axis through both home
+ * triangles exchanges rows and columns, and maps each position onto one of
+ * identical value, in which the moves are reflected in the same way.
+ */
+
+/**
+ * Reflect a set of cells in the axis of symmetry of the board.
+ *
+ * @param b  The cells to be reflected.
+ * @return  The reflected cells.
+ */
+Bitboard mirror_bb(Bitboard b);
+
+/**
+ * Reflect a move in the axis of symmetry of the board.  Applying mirror_move
+ * twice gives back the original move.
+ *
+ * @param m  The move to be reflected.
+ * @return  The corresponding move in the reflected position.
+ */
+Move mirror_move(Move m);
+
+/**
+ * Get the canonical orientation of the position on a board: whichever of
+ * the position and its reflection has the smaller occupancy masks, comparing
+ * X's pieces first.  A position and its reflection have the same canonical
+ * orientation.  The player to move is not affected by reflection.
+ *
+ * @param bp  The board whose position is to be canonicalized.
+ * @param occ  Filled in with the cells occupied by X and by O in the
+ * canonical orientation.
+ * @return  1 if the canonical orientation is the reflection of the position
+ * on the board (so moves found in it must be passed through mirror_move
+ * before they are applied to the board), 0 if it is the position itself.
+ */
+int canonical_position(Board *bp, Bitboard occ[2]);
+
+/*
+ * Packed position codes.  A position is stored in 16 bytes as the 81-bit
+ * mask of occupied cells (bit 9 * r + c for row r, column c), followed by
+ * one bit per occupied cell, in increasing order of cell, that is set if
+ * the piece belongs to O, followed by one bit that is set if O is to move.
+ * The bit string is stored least significant byte first.  Pieces of the
+ * same player are indistinguishable, so every position has exactly one
+ * code, and the code does not depend on the host byte order.
+ */
+#define POSCODE_BYTES 16
+
+typedef struct poscode {
+    unsigned char bytes[POSCODE_BYTES];
+} Poscode;
+
+/**
+ * Encode the position on a board.
+ *
+ * @param bp  The board whose position is to be encoded.
+ * @param pc  The code to be filled in.
+ */
+void encode_position(Board *bp, Poscode *pc);
+
+/**
+ * Set up a board with a position previously encoded by encode_position.
+ * The move number and move log are not part of the position, and are
+ * reset as by setbd.
+ *
+ * @param pc  The code to be decoded.
+ * @param bp  The board to be set up.
+ * @return  bp, or NULL if the code does not describe a position with
+ * NPIECES pieces for each player.
+ */
+Board *decode_position(const Poscode *pc, Board *bp);
+
+/* Move generation. */
+
+extern _Thread_local Move resultlist[];   // Moves found by the generator
+extern _Thread_local Move *resultp;       // End of the moves in resultlist
+extern _Thread_local long jumpgens, stepgens; // Calls to the jump/step generators
+extern _Thread_local long jumptot, steptot;   // Moves produced by those calls
+
+/*
+ * Hop paths.  A Move records only where a piece starts and where it ends;
+ * the cells it visits in between, on a jump, are recorded separately where
+ * they are needed, so that moves can be printed without searching the
+ * board for a chain of hops.
+ */
+#define MAXPATH (BDSIZE * BDSIZE)         // Longest chain of cells in a move
+
+typedef struct hoppath {
+    int len;                              // Number of cells, including both ends
+    unsigned char point[MAXPATH];         // Cells visited in order, as POINTs
+} Hoppath;
+
+/*
+ * The generator writes into caller-provided buffers, and is re-entrant
+ * apart from the statistics counters.  A buffer of MAXMOVES entries is
+ * always big enough: moves that do not fit in the capacity given are
+ * dropped.
+ */
+
+/**
+ * Find all the cells that a piece can reach by a sequence of hops.
+ *
+ * @param bp  The board on which the piece stands.
+ * @param s  Square index of the piece.
+ * @param reached  Filled in with the square indices of the cells reached,
+ * in order of increasing number of hops.  BDSIZE * BDSIZE entries suffice.
+ * @param pred  Indexed by square, filled in for each cell reached with the
+ * square from which the last hop to it was made, so that following pred
+ * back from a destination to s gives a shortest chain of hops.  Entries for
+ * cells not reached are left unchanged.
+ * @return  The number of cells reached.
+ */
+int jump_closure(Board *bp, int s, unsigned char *reached, unsigned char *pred);
+
+/**
+ * Check whether a piece can reach a cell by a sequence of hops.
+ *
+ * @param bp  The board on which the piece stands.
+ * @param s  Square index of the piece.
+ * @param t  Square index of the cell.
+ * @return  1 if the cell can be reached, 0 if not.
+ */
+int jump_reaches(Board *bp, int s, int t);
+
+/**
+ * Generate all the jump moves (resp. single-step moves) for one piece of
+ * the player to move.  Each distinct destination that can be reached by a
+ * sequence of hops is produced exactly once.
+ *
+ * @param bp  The board for which moves are to be generated.
+ * @param s  Square index of the piece to be moved.
+ * @param out  Storage for the moves.
+ * @param cap  The number of moves that out can hold.
+ * @return  The number of moves stored.
+ */
+int gen_jumps_from(Board *bp, int s, Move *out, int cap);
+int gen_steps_from(Board *bp, int s, Move *out, int cap);
+
+/**
+ * Generate all the jump moves (resp. step moves, resp. moves of either
+ * kind) available to the player to move.
+ *
+ * @param bp  The board for which moves are to be generated.
+ * @param out  Storage for the moves.
+ * @param cap  The number of moves that out can hold.
+ * @return  The number of moves stored.
+ */
+int gen_jumps(Board *bp, Move *out, int cap);
+int gen_steps(Board *bp, Move *out, int cap);
+int gen_moves(Board *bp, Move *out, int cap);
+
+/**
+ * Generate all the jump moves available to the player to move, recording
+ * the chain of hops of each in a side table.
+ *
+ * @param bp  The board for which moves are to be generated.
+ * @param out  Storage for the moves.
+ * @param paths  Storage for the paths, parallel to out.
+ * @param cap  The number of moves that out and paths can hold.
+ * @return  The number of moves stored.
+ */
+int gen_jumps_with_paths(Board *bp, Move *out, Hoppath *paths, int cap);
+
+/**
+ * Find the cells visited by a move: a shortest chain of hops for a jump.
+ * This searches the board, and is for moves whose path was not recorded.
+ *
+ * @param bp  The board to which the move applies.
+ * @param m  The move.
+ * @param path  Filled in with the path of the move.
+ * @return  0 on success, -1 if the move is neither a step nor a jump that
+ * can be made on the board.
+ */
+int move_path(Board *bp, Move m, Hoppath *path);
+
+/**
+ * Check that a path is a possible chain of cells for a move: either the
+ * single step of the move, or a sequence of hops, each over an occupied
+ * cell onto an empty one, from the source of the move to its destination.
+ *
+ * @param bp  The board to which the move applies.
+ * @param m  The move.
+ * @param path  The path to be checked.
+ * @return  1 if the path is possible, 0 if not.
+ */
+int check_path(Board *bp, Move m, const Hoppath *path);
+
+/**
+ * Check whether the two armies are still in contact: that is, whether some
+ * piece of O is not yet beyond every piece of X, on the way to O's goal.
+ * Once they are not, neither player can ever hop over the other's pieces,
+ * and no move that loses ground towards the goal is worth considering.
+ *
+ * @param bp  The board to be examined.
+ * @return  1 if the armies are in contact, 0 if they have passed.
+ */
+int in_contact(Board *bp);
+
+/**
+ * Generate only the jump moves (resp. step moves) available to the player
+ * to move that lose no ground towards the goal.  A jump may still pass
+ * through cells further from the goal on the way to its destination.
+ *
+ * @param bp  The board for which moves are to be generated.
+ * @param out  Storage for the moves.
+ * @param cap  The number of moves that out can hold.
+ * @return  The number of moves stored.
+ */
+int gen_forward_jumps(Board *bp, Move *out, int cap);
+int gen_forward_steps(Board *bp, Move *out, int cap);
+
+/**
+ * Replace the contents of resultlist by all the jump moves (resp. step moves,
+ * resp. moves of either kind) available to the player to move.  These are
+ * for callers that are content to share the global list.
+ *
+ * @param bp  The board for which moves are to be generated.
+ */
+void jump_moves(Board *bp);
+void step_moves(Board *bp);
+void moves(Board *bp);
+
+/* Search. */
+
+#define MOVESTACK ((MAXPLY + 1) * MAXMOVES) // Entries in a search move stack
+
+extern volatile sig_atomic_t stop_search; // Set asynchronously to abandon a search
+
+/*
+ * Late move reductions: moves tried late at a node, other than killers and
+ * forward jumps, are first searched lmr_reduction plies less deep.
+ */
+#define LMR_REDUCTION 1                   // Default plies of reduction
+#define LMR_MOVES 3                       // Default moves searched fully first
+
+extern int lmr_reduction;                 // Plies of reduction, 0 for none
+extern int lmr_moves;                     // Moves at a node not reduced
+
+/*
+ * Parallel search.  The search of each position may be shared among
+ * several threads, each with its own copy of the board and its own move
+ * lists and statistics; only the transposition table is common to them.
+ * Alternatively, the moves at the root may be split between several
+ * processes, which share only the best score found so far.
+ */
+#define MAXTHREADS 64                     // Limit on search_threads
+#define MAXPROCS 64                       // Limit on search_procs
+
+extern int search_threads;                // Threads to search with, at least 1
+extern int search_procs;                  // Processes to split the root between
+
+/**
+ * Start the helper threads of the search, ending any started before.  Must
+ * be called before any search, and not while one is in progress.  The
+ * helpers wait for work between searches, and keep searching a position
+ * from one search of it to the next, until smp_idle is called or another
+ * position is searched.
+ *
+ * @param threads  The total number of threads to search with, including
+ * the one calling search, at most MAXTHREADS.
+ * @return  0 on success, -1 if threads is more than MAXTHREADS or the
+ * helpers could not be allocated.
+ */
+int smp_init(int threads);
+
+/**
+ * Stop the helper threads searching until the next search, and wait until
+ * they have stopped.  Called when the searches of a position are over,
+ * such as when a move is played, and before the transposition table is
+ * aged or cleared.
+ */
+void smp_idle(void);
+
+/**
+ * Set up the memory shared by the processes splitting the root of the
+ * search.  Must be called before any search, and not while one is in
+ * progress.  While more than one process is in use, helper threads are not.
+ *
+ * @param procs  The total number of processes to search with, including
+ * the one calling search, at most MAXPROCS.
+ * @return  0 on success, -1 if procs is more than MAXPROCS or the shared
+ * memory could not be mapped.
+ */
+int split_init(int procs);
+
+/**
+ * Search the position on a board to the current depth limit, leaving the
+ * best line found in principal_var.  The move lists of all the plies of
+ * the search are kept in the move stack supplied, so searches with
+ * separate stacks (and boards) do not share any move lists.  The search may
+ * be abandoned at any time by setting stop_search, in which case the board
+ * is unwound to the position at which the search began, and the search may
+ * simply be started again once stop_search has been cleared.
+ *
+ * @param bp  The board to be searched.  It is modified during the search,
+ * but is restored before this function returns.
+ * @param stack  Storage for the move lists, of MOVESTACK entries.
+ * @return  The score of the position for the player to move.  The value is
+ * meaningless if stop_search was set during the search, and principal_var
+ * is then left as it was.
+ */
+int search(Board *bp, Move *stack);
+
+/**
+ * Search as search does, but with a window narrower than the full range of
+ * scores.  The principal variation is only complete if the score falls
+ * strictly inside the window.
+ *
+ * @param bp  The board to be searched.
+ * @param stack  Storage for the move lists, of MOVESTACK entries.
+ * @param alpha  The lower end of the window.
+ * @param beta  The upper end of the window.
+ * @return  The score of the position for the player to move, if it is
+ * strictly inside the window.  Otherwise alpha if the score is at most
+ * alpha, and beta if it is at least beta.
+ */
+int search_window(Board *bp, Move *stack, int alpha, int beta);
+
+/**
+ * Halve the history counts used to order moves, so that the cutoffs found
+ * in earlier positions weigh less than those to come.  It is called once
+ * for each move played, like tt_new_search.
+ */
+void age_history(void);
+
+/**
+ * Get the path of a move from the position at the root of the last search,
+ * as recorded by the generator.  If the move was not recorded, or the board
+ * is not in that position, the path is found by searching the board.
+ *
+ * @param bp  The board in the position at the root of the search.
+ * @param m  The move.
+ * @param path  Filled in with the path of the move.
+ * @return  0 on success, -1 if the path could not be found.
+ */
+int root_path(Board *bp, Move m, Hoppath *path);
+
+/*
+ * Transposition table.  Results of searches are kept by Zobrist key, with
+ * the depth to which the position was searched, the kind of bound the
+ * score is, and the best move found (MOVE_END if none).  Scores are from
+ * the point of view of the player to move in the position.  The table may
+ * be used by several search threads at once.
+ */
+#define TT_DEFAULT_MB 16                  // Default size of the table
+
+enum { TT_NONE, TT_EXACT, TT_LOWER, TT_UPPER };
+
+typedef struct {
+    Move move;                            // Best move, or MOVE_END
+    int score;
+    unsigned char depth;                  // Plies searched below the position
+    unsigned char bound;                  // TT_EXACT, TT_LOWER or TT_UPPER
+    unsigned char age;                    // Search in which it was stored
+} Ttentry;
+
+extern int tt_megabytes;                  // Size of the table to be allocated
+extern _Thread_local int tt_probes, tt_hits, tt_cutoffs;  // Statistics since reset_stats
+
+/**
+ * (Re)allocate the transposition table, empty.
+ *
+ * @param megabytes  The size of the table; it is rounded down to a power of
+ * two.  If zero, the table is not used.
+ * @return  0 on success, -1 if the table could not be allocated.
+ */
+int tt_init(int megabytes);
+
+/** Empty the transposition table. */
+void tt_clear(void);
+
+/**
+ * Note the start of the search of a new position, so that entries from
+ * earlier searches are the first to be replaced.  It is called once for
+ * each move played, not for each iteration of a deepening search, so that
+ * the entries of the shallower iterations keep their place.
+ */
+void tt_new_search(void);
+
+/**
+ * Look up a position in the transposition table.
+ *
+ * @param key  The Zobrist key of the position.
+ * @param e  Filled in with a copy of the entry for the position.
+ * @return  1 if there is an entry for the position, otherwise 0.
+ */
+int tt_probe(uint64_t key, Ttentry *e);
+
+/**
+ * Record the result of searching a position.
+ *
+ * @param key  The Zobrist key of the position.
+ * @param depth  The number of plies searched below the position.
+ * @param bound  TT_EXACT, TT_LOWER or TT_UPPER.
+ * @param score  The score, from the point of view of the player to move.
+ * @param best  The best move found, or MOVE_END.
+ */
+void tt_store(uint64_t key, int depth, int bound, int score, Move best);
+
+/* Evaluation and statistics. */
+
+extern _Thread_local int nodes;           // Positions evaluated since reset_stats
+extern int window_alpha, window_beta;     // Aspiration window of the last search
+extern int window_score;                  // Score returned by the last search
+extern int researches;                    // Searches repeated with a wider window
+
+/**
+ * Static evaluator.
+ *
+ * @param bp  The board to be evaluated.
+ * @param p  The player from whose point of view the score is given.
+ * @return  MAXEVAL-1 if p has won, -(MAXEVAL-1) if p has lost, and otherwise
+ * a heuristic score, positive if the position favors p.
+ */
+int eval(Board *bp, Player p);
+
+/* Input and output of board points, in the form "A1" through "I9". */
+
+extern int peekc;                         // Lookahead character for input
+
+int input_point(FILE *f);
+void print_point(int pt, FILE *s);
+
+/**
+ * Format a move into a string, exactly as print_move would print it.
+ *
+ * @param bp  The board to which the move applies.
+ * @param m  The move to be formatted.
+ * @param buf  Storage for the result, of at least MOVE_TEXT bytes.
+ * @return  The length of the result, or -1 if the hops of a jump could not
+ * be traced on the board, in which case buf holds only the start of the
+ * move.
+ */
+int sprint_move(Board *bp, Move m, char *buf);
+
+/**
+ * Format (resp. print) a move with a known path, in the same notation as
+ * print_move but without consulting the board.
+ *
+ * @param m  The move to be formatted.
+ * @param path  The path of the move, as found by the generator or read
+ * with the move.
+ * @param buf  Storage for the result, of at least MOVE_TEXT bytes.
+ * @param s  The output stream to which the move is to be printed.
+ * @return  The length of the result.
+ */
+int sprint_move_with_path(Move m, const Hoppath *path, char *buf);
+void print_move_with_path(Move m, const Hoppath *path, FILE *s);
+
+/**
+ * Read a move from a stream, as read_move_from_pipe does, keeping the chain
+ * of cells given for it.  If only the ends of a jump are given, the chain
+ * is found by searching the board.  A chain that is not possible for the
+ * move causes an abort, as does any other error.
+ *
+ * @param str  The stream from which to read the move.
+ * @param bp  The current game board.
+ * @param path  Filled in with the path of the move.
+ * @return  The move that was read, or 0 if EOF was seen.
+ */
+Move read_move_with_path(FILE *str, Board *bp, Hoppath *path);
+
+/* Reasons for replay_moves to stop. */
+enum { REPLAY_END, REPLAY_ILLEGAL, REPLAY_LIMIT, REPLAY_FULL };
+
+/**
+ * Parse a sequence of moves from text and apply them to a board.  Each move
+ * is on a line of its own, in the form printed by print_move, optionally
+ * preceded by a move number as in a transcript ("12. white:A1-A3" or
+ * "12. ... black:I9-G9"); only the points after the colon are significant.
+ * Blank lines and lines without a colon are skipped.  Each move is checked
+ * once, by legal_move, and its notation is formatted before it is applied.
+ * Replay stops at the first move that is malformed or illegal, at a move
+ * beyond the first max, or at one whose notation does not fit in the
+ * buffer.
+ *
+ * @param bp  The board to which the moves are to be applied.
+ * @param text  The moves, as a NUL-terminated string.
+ * @param max  The maximum number of moves to apply.
+ * @param mv  If not NULL, receives the moves applied.
+ * @param notation  If not NULL, receives the notation of each move applied,
+ * as by sprint_move, each followed by a newline.
+ * @param size  The size of the notation buffer.
+ * @param endp  If not NULL, set to point at the line at which replay stopped.
+ * @param why  If not NULL, set to the reason replay stopped: REPLAY_END at
+ * the end of the text, REPLAY_ILLEGAL at a malformed or illegal move,
+ * REPLAY_LIMIT with max moves applied and more to come, or REPLAY_FULL
+ * when the notation buffer is full.
+ * @return  The number of moves applied.
+ */
+int replay_moves(Board *bp, const char *text, int max, Move *mv,
+                 char *notation, size_t size, const char **endp, int *why);
+
+#endif /* BOARD_H */
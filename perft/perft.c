@@ -0,0 +1,237 @@
+/*
+ * perft: move generator benchmark and self-check.
+ *
+ * Counts the positions reached after every sequence of N moves from the
+ * start position, and then from the final position of each saved
+ * transcript named on the command line, and reports the rate at which the generator,
+ * apply and undo got through them.  A position in which the game is over
+ * counts as a leaf, whatever the depth.
+ *
+ * Options:
+ *   -d <num>     depth in ply (default 3)
+ *   -D           divide: for each move from the root, compare the counts
+ *                found using the move generator with those found using a
+ *                reference generator built on legal_move
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+static Move move_stack[MOVESTACK];
+static long leaf_jumps, leaf_steps;        // Leaves reached by each kind of move
+
+/* Type of a generator of all the moves for the player to move. */
+typedef int (*Generator)(Board *bp, Move *out, int cap);
+
+/* The move generator under test, split into its two halves. */
+static int gen_split(Board *bp, Move *out, int cap)
+{
+    int n = gen_jumps(bp, out, cap);
+
+    return n + gen_steps(bp, out + n, cap - n);
+}
+
+/*
+ * Reference generator: try every destination for every piece and keep the
+ * ones that legal_move accepts.  Slow, but it shares no code with the move
+ * generator apart from the board.
+ */
+static int gen_reference(Board *bp, Move *out, int cap)
+{
+    Player p = player_to_move(bp);
+    int n = 0;
+
+    for (int i = 0; i < NPIECES; i++) {
+        int s = bp->pieces[p][i];
+        for (int r = 0; r < BDSIZE; r++) {
+            for (int c = 0; c < BDSIZE; c++) {
+                Move m = MAKE_MOVE(p, SQ_POINT(s), POINT(r, c));
+                if (n < cap && legal_move(m, bp))
+                    out[n++] = m;
+            }
+        }
+    }
+    return n;
+}
+
+static long perft(Board *bp, int d, Generator gen, Move *ms)
+{
+    long count = 0;
+
+    if (game_over(bp))
+        return 1;
+    if (gen == gen_split && d == 1) {
+        /* Count the leaves without visiting them */
+        int jumps = gen_jumps(bp, ms, MAXMOVES);
+        int steps = gen_steps(bp, ms, MAXMOVES);
+        leaf_jumps += jumps;
+        leaf_steps += steps;
+        return jumps + steps;
+    }
+    int n = gen(bp, ms, MAXMOVES);
+    if (d == 1)
+        return n;
+    for (int i = 0; i < n; i++) {
+        apply(bp, ms[i]);
+        count += perft(bp, d - 1, gen, ms + n);
+        undo(bp);
+    }
+    return count;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Count and time the leaves to a given depth from one position. */
+static void run(Board *bp, const char *name, int d)
+{
+    leaf_jumps = leaf_steps = 0;
+    jumpgens = stepgens = jumptot = steptot = 0;
+    double start = now();
+    long nodes = perft(bp, d, gen_split, move_stack);
+    double elapsed = now() - start;
+
+    printf("%s: depth %d: %ld nodes (%ld by jumps, %ld by steps)"
+           " in %.3fs, %.0f nodes/s\n",
+           name, d, nodes, leaf_jumps, leaf_steps, elapsed,
+           elapsed > 0 ? nodes / elapsed : 0.0);
+    printf("    JG: %ld/%ld, SG: %ld/%ld\n", jumptot, jumpgens, steptot, stepgens);
+}
+
+/*
+ * Compare the counts below each move from one position, as found with the
+ * move generator and with the reference generator.  Returns the number of
+ * discrepancies.
+ */
+static int divide(Board *bp, const char *name, int d)
+{
+    Move root[MAXMOVES], ref[MAXMOVES];
+    char text[MOVE_TEXT];
+    int errors = 0;
+    int n = gen_split(bp, root, MAXMOVES);
+    int nref = gen_reference(bp, ref, MAXMOVES);
+
+    printf("%s: depth %d: %d moves (reference %d)\n", name, d, n, nref);
+    if (n != nref)
+        errors++;
+    for (int i = 0; i < n; i++) {
+        int found = 0;
+        for (int j = 0; j < nref; j++) {
+            if (ref[j] == root[i])
+                found = 1;
+        }
+        sprint_move(bp, root[i], text);
+        apply(bp, root[i]);
+        long count = d > 1 ? perft(bp, d - 1, gen_split, move_stack) : 1;
+        long refcount = !found ? 0
+                      : d > 1 ? perft(bp, d - 1, gen_reference, move_stack) : 1;
+        undo(bp);
+        printf("    %-24s %10ld %10ld%s\n", text, count, refcount,
+               count != refcount ? "  ***" : "");
+        if (count != refcount)
+            errors++;
+    }
+    /* Moves found only by the reference generator */
+    for (int j = 0; j < nref; j++) {
+        int found = 0;
+        for (int i = 0; i < n; i++) {
+            if (root[i] == ref[j])
+                found = 1;
+        }
+        if (found)
+            continue;
+        sprint_move(bp, ref[j], text);
+        apply(bp, ref[j]);
+        long refcount = d > 1 ? perft(bp, d - 1, gen_reference, move_stack) : 1;
+        undo(bp);
+        printf("    %-24s %10d %10ld  ***\n", text, 0, refcount);
+        errors++;
+    }
+    return errors;
+}
+
+/* Set up a board with the final position of a saved transcript. */
+static Board *load(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    char *text;
+    long len;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) < 0 || (len = ftell(f)) < 0) {
+        perror(filename);
+        if (f)
+            fclose(f);
+        return NULL;
+    }
+    rewind(f);
+    if ((text = malloc(len + 1)) == NULL) {
+        fclose(f);
+        return NULL;
+    }
+    text[fread(text, 1, len, f)] = '\0';
+    fclose(f);
+
+    Board *bp = newbd();
+    const char *stop;
+    int why;
+    if (bp != NULL) {
+        replay_moves(bp, text, MAXGAME, NULL, NULL, 0, &stop, &why);
+        if (why == REPLAY_ILLEGAL)
+            fprintf(stderr, "%s: illegal move: %.*s\n", filename,
+                    (int)strcspn(stop, "\n"), stop);
+        else if (why == REPLAY_LIMIT)
+            fprintf(stderr, "%s: more than %d moves, stopped at: %.*s\n",
+                    filename, MAXGAME, (int)strcspn(stop, "\n"), stop);
+    }
+    free(text);
+    return bp;
+}
+
+int main(int argc, char *argv[])
+{
+    int d = 3, div = 0, errors = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "d:D")) != -1) {
+        switch (c) {
+        case 'd':
+            d = atoi(optarg);
+            break;
+        case 'D':
+            div = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-d depth] [-D] [transcript ...]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (d < 1 || d > MAXPLY) {
+        fprintf(stderr, "Depth must be between 1 and %d\n", MAXPLY);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = optind - 1; i < argc; i++) {
+        const char *name = i < optind ? "start" : argv[i];
+        Board *bp = i < optind ? newbd() : load(name);
+        if (bp == NULL)
+            return EXIT_FAILURE;
+        if (div)
+            errors += divide(bp, name, d);
+        else
+            run(bp, name, d);
+        freebd(bp);
+    }
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
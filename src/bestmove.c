@@ -0,0 +1,821 @@
+/*
+ * Game tree search.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+int randomized;
+int depth;
+int lmr_reduction = LMR_REDUCTION;
+int lmr_moves = LMR_MOVES;
+int search_threads = 1;
+int search_procs = 1;
+Move principal_var[MAXPLY + 1];
+volatile sig_atomic_t stop_search;
+
+/* Score returned for a subtree that was cut off. */
+#define PRUNED (MAXEVAL + 1)
+
+/* Net distance towards the goal (row + column) covered by a move. */
+static int advance(Move m)
+{
+    return (row_to(m) - row_from(m)) + (col_to(m) - col_from(m));
+}
+
+/*
+ * Moves that caused cutoffs are remembered in two ways: as killers, the
+ * last two moves to cause a cutoff at each ply, and in the history table,
+ * which counts the cutoffs caused by each move from one cell to another,
+ * weighted by the depth of the subtree cut off.  History counts are kept
+ * below HISTORY_MAX by halving the whole table when one reaches it, and
+ * are halved for every move played so that old results fade.
+ */
+#define HISTORY_MAX (1 << 16)
+
+static _Thread_local Move killers[MAXPLY + 1][2];
+static _Thread_local unsigned history[2][BDSIZE * BDSIZE][BDSIZE * BDSIZE];
+
+static inline unsigned *history_of(Player p, Move m)
+{
+    return &history[p][row_from(m) * BDSIZE + col_from(m)]
+                      [row_to(m) * BDSIZE + col_to(m)];
+}
+
+void age_history(void)
+{
+    for (Player p = X; p <= O; p++)
+        for (int i = 0; i < BDSIZE * BDSIZE; i++)
+            for (int j = 0; j < BDSIZE * BDSIZE; j++)
+                history[p][i][j] /= 2;
+}
+
+/* Remember a move that caused a cutoff at ply d, with r plies below it. */
+static void note_cutoff(Player p, int d, int r, Move m)
+{
+    unsigned *h = history_of(p, m);
+
+    if (killers[d][0] != m) {
+        killers[d][1] = killers[d][0];
+        killers[d][0] = m;
+    }
+    if ((*h += r * r) >= HISTORY_MAX)
+        age_history();
+}
+
+/*
+ * Moves are ordered by a small score packed above the bits of the move
+ * itself and MOVE_END: the progress they make for the player to move,
+ * biased to be non-negative, and below that the top bits of their history
+ * count, to break ties between moves making the same progress.  Sorting the
+ * packed words on their top bits sorts the moves.
+ */
+#define SCORE_SHIFT 18
+#define SCORE_BIAS (2 * BDSIZE)
+#define HISTORY_BITS 8
+
+static Move with_score(Player p, Move m)
+{
+    int s = (p == X) ? advance(m) : -advance(m);
+    unsigned h = *history_of(p, m) >> (16 - HISTORY_BITS);
+
+    return ((((Move)(s + SCORE_BIAS) << HISTORY_BITS) | h) << SCORE_SHIFT) | m;
+}
+
+/* Move stack for searches started through bestmove itself. */
+static Move default_stack[MOVESTACK];
+
+/*
+ * Side table of the jumps available at the root of the last search, with
+ * their chains of hops, so that the move chosen can be printed without
+ * searching the board again.
+ */
+static uint64_t root_key;                 // Key of the root position
+static int root_jumps;                    // Number of jumps in the table
+static Move root_moves[MAXMOVES];
+static Hoppath root_paths[MAXMOVES];
+
+/*
+ * Helper threads for parallel search ("lazy SMP").  While the calling
+ * thread searches the root, each helper searches the same position on its
+ * own board, deepening from the same depth or one ply deeper until it
+ * reaches MAXPLY or is given other work.  The helpers report nothing
+ * directly: what they find reaches the main search through the
+ * transposition table, as cutoffs and as best moves to try first.  Their
+ * own killers and history make them search in different orders, so they
+ * tend to fill in different parts of the tree.
+ *
+ * The helpers are started once, by smp_init, and wait between jobs.  A job
+ * is the search of one root position; it lasts across all the iterations
+ * and re-searches of a move, each of which only raises helpers_depth, the
+ * least depth that the helpers go on to search.  Changing helpers_job
+ * abandons the current job; like any stopped search, the helpers then
+ * leave the subtrees they are in without storing anything, so that no
+ * bound from an unfinished search reaches the table.
+ */
+struct helper {
+    pthread_t thread;
+    int running;
+    int odd;                              // Searches a ply deeper if set
+    int nodes;                            // Statistics not yet collected
+    long jumpgens, stepgens, jumptot, steptot;
+    int tt_probes, tt_hits, tt_cutoffs;
+    Board board;
+    Move pv[MAXPLY + 1];
+    Move stack[MOVESTACK];
+};
+
+static struct helper *helpers;
+static int nhelpers;
+static pthread_mutex_t helpers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t helpers_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t helpers_done = PTHREAD_COND_INITIALIZER;
+static Board helpers_root;                // Position of the current job
+static int helpers_idle = 1;              // Set while there is no job
+static int helpers_busy;                  // Helpers working on a job
+static int helpers_quit;                  // Set to end the helper threads
+static atomic_int helpers_job;            // Number of the current job
+static atomic_int helpers_depth;          // Least depth to search
+static _Thread_local int is_helper;
+static _Thread_local int helper_job;      // Job this helper is working on
+
+/*
+ * State shared by the processes splitting the root of a search, in memory
+ * mapped by all of them: the best score yet found at the root by any of
+ * them, and a flag set when the search is to be abandoned.
+ */
+struct rootshare {
+    atomic_int alpha;
+    atomic_int stop;
+};
+
+static struct rootshare *share;           // NULL unless splitting the root
+
+/* Check whether the search being run by this thread is to be abandoned. */
+static inline int stopped(void)
+{
+    return stop_search
+        || (is_helper && atomic_load_explicit(&helpers_job, memory_order_relaxed) != helper_job)
+        || (share != NULL && atomic_load_explicit(&share->stop, memory_order_relaxed));
+}
+
+/*
+ * Staged move generation.  The moves of a node are produced in stages, and
+ * each stage is generated only when the moves of the previous one have all
+ * been searched without a cutoff:
+ *
+ *      STAGE_PV:     the best move from the previous iteration, or from
+ *                    the transposition table
+ *      STAGE_KILLERS: the killer moves of the ply, if they are legal here
+ *      STAGE_JUMPS:  jumps, most progress first
+ *      STAGE_STEPS:  steps, most progress first
+ *
+ * A move tried in an earlier stage is skipped when it comes up again.
+ * Once the armies have passed each other, only moves that lose no ground
+ * are generated, unless there are none, in which case the stages are run
+ * again with all the moves.
+ */
+enum stage { STAGE_PV, STAGE_KILLERS, STAGE_JUMPS, STAGE_STEPS, STAGE_DONE };
+
+struct picker {
+    Board *bp;
+    Player p;
+    enum stage stage;
+    int forward;                          // Generate forward moves only
+    int tried;                            // Moves returned so far
+    Move pvmove;                          // Move of STAGE_PV, or MOVE_END
+    Move killer[2];                       // Moves of STAGE_KILLERS, or MOVE_END
+    Move *list;                           // Moves of the current stage
+    Move *next;                           // Next of them to be tried
+    Move *end;                            // End of them, and of the stack in use
+};
+
+/*
+ * Sort a list of moves, best first.  The lists are short, so an insertion
+ * sort on the packed scores does, and moves of equal score keep the order
+ * in which they were generated.
+ */
+static void order_moves(Player p, Move *list, int n)
+{
+    for (int i = 0; i < n; i++) {
+        Move w = with_score(p, list[i]);
+        int j = i;
+        while (j > 0 && (list[j - 1] >> SCORE_SHIFT) < (w >> SCORE_SHIFT)) {
+            list[j] = list[j - 1];
+            j--;
+        }
+        list[j] = w;
+    }
+    for (int i = 0; i < n; i++)
+        list[i] &= (1 << SCORE_SHIFT) - 1;
+}
+
+/*
+ * Check that a move remembered from another search at least moves one of
+ * the pieces of the player to move.  This is only a quick test to spare
+ * legal_move, which a remembered move must also pass before it is tried:
+ * the transposition table may return the move of another position, from a
+ * key collision or a slot torn by two threads.
+ */
+static int plausible(Board *bp, Player p, Move m)
+{
+    return !IS_PASS(m) && (m & MOVE_PLAYER) == (p == O ? MOVE_PLAYER : 0)
+        && (bp->occ[p] & BIT(SQUARE(row_from(m), col_from(m))));
+}
+
+static void init_picker(struct picker *pk, Board *bp, Player p, int d,
+                        Move pvmove, Move *ms)
+{
+    pk->bp = bp;
+    pk->p = p;
+    pk->stage = STAGE_PV;
+    pk->forward = !in_contact(bp);
+    pk->tried = 0;
+    pk->pvmove = (plausible(bp, p, pvmove) && legal_move(pvmove, bp))
+                 ? pvmove : MOVE_END;
+    for (int i = 0; i < 2; i++) {
+        Move k = killers[d][i];
+        pk->killer[i] = (k != pk->pvmove && plausible(bp, p, k)
+                         && legal_move(k, bp)) ? k : MOVE_END;
+    }
+    pk->list = pk->next = pk->end = ms;
+    if (pk->pvmove != MOVE_END)
+        *pk->end++ = pk->pvmove;
+}
+
+/* Get the next move to try, or MOVE_END when there are no more. */
+static Move next_move(struct picker *pk)
+{
+    while (1) {
+        while (pk->next < pk->end) {
+            Move m = *pk->next++;
+            if (pk->stage <= STAGE_KILLERS || (m != pk->pvmove
+                && m != pk->killer[0] && m != pk->killer[1])) {
+                pk->tried++;
+                return m;
+            }
+        }
+        int n;
+        switch (pk->stage) {
+        case STAGE_PV:
+            pk->stage = STAGE_KILLERS;
+            pk->next = pk->end = pk->list;
+            for (int i = 0; i < 2; i++) {
+                if (pk->killer[i] != MOVE_END)
+                    *pk->end++ = pk->killer[i];
+            }
+            continue;
+        case STAGE_KILLERS:
+            pk->stage = STAGE_JUMPS;
+            n = pk->forward ? gen_forward_jumps(pk->bp, pk->list, MAXMOVES)
+                            : gen_jumps(pk->bp, pk->list, MAXMOVES);
+            break;
+        case STAGE_JUMPS:
+            pk->stage = STAGE_STEPS;
+            n = pk->forward ? gen_forward_steps(pk->bp, pk->list, MAXMOVES)
+                            : gen_steps(pk->bp, pk->list, MAXMOVES);
+            break;
+        default:
+            if (pk->forward && pk->tried == 0) {
+                pk->forward = 0;
+                pk->stage = STAGE_PV;
+                continue;
+            }
+            pk->stage = STAGE_DONE;
+            return MOVE_END;
+        }
+        order_moves(pk->p, pk->list, n);
+        pk->next = pk->list;
+        pk->end = pk->list + n;
+    }
+}
+
+/*
+ * Check whether a move just taken from a picker, at a node with left plies
+ * to go, is a late move whose search may be reduced.  Reductions are kept
+ * from leaving less than one ply to search.
+ */
+static int late_move(struct picker *pk, Move m, int left)
+{
+    if (lmr_reduction <= 0 || pk->tried <= lmr_moves || left - 1 - lmr_reduction < 1)
+        return 0;
+    if (pk->stage == STAGE_STEPS)
+        return 1;
+    return pk->stage == STAGE_JUMPS
+        && ((pk->p == X) ? advance(m) : -advance(m)) <= 0;
+}
+
+/*
+ * At the root of a deepening search, the best move from the previous
+ * iteration is tried first of all; elsewhere, the best move recorded in
+ * the transposition table for the position, if any.  A table entry from a
+ * search at least as deep ends the search of a node when its bound alone
+ * decides the outcome against the window.  An exact score inside the window
+ * is not taken from the table, as the line leading to it would be missing
+ * from the principal variation.
+ *
+ * The search is a principal variation search: only the first move of a
+ * node is searched with the full window.  The rest are searched with a
+ * null window just above alpha, which can only show whether a move is
+ * better than the best so far, and are searched again with the full window
+ * when one is.  With the best move usually first, most of them are refuted
+ * cheaply.
+ *
+ * Late moves, those tried after the first lmr_moves of a node that are
+ * neither killers nor forward jumps, are unlikely to be best, and their
+ * scout searches are cut short by lmr_reduction plies.  A late move that
+ * fails high on the reduced search is searched again to the full depth.
+ *
+ * Nodes are searched to left more plies; d is the ply of the node from the
+ * root.  Once the search is stopped, every node reports a cutoff, whether
+ * before searching or after abandoning its moves, so that its parent
+ * discards the subtree and the search unwinds without storing anything.
+ * The moves of this node are listed at ms, and those of its subtrees
+ * immediately above them.
+ */
+static int negamax(Board *bp, Player p, int d, int left, Move *pvar,
+                   int alpha, int beta, Move *ms)
+{
+    Move pv[MAXPLY + 1];
+    struct picker pk;
+    Ttentry e;
+    Move m, best = MOVE_END, hint = MOVE_END;
+    int alpha0 = alpha;
+    int val;
+
+    if (stopped())
+        return PRUNED;
+    val = eval(bp, p);
+    if (left == 0)
+        return -val;
+    if (val == -(MAXEVAL - 1) || val == MAXEVAL - 1) {
+        for (int i = d; i < d + left; i++) {
+            pvar[i] = (p == X) ? 0 : MOVE_PLAYER;
+            p = 1 - p;
+        }
+        return -val;
+    }
+
+    if (tt_probe(board_key(bp), &e)) {
+        if (d > 0 && e.depth >= left) {
+            if (e.bound != TT_UPPER && e.score >= beta) {
+                tt_cutoffs++;
+                return PRUNED;
+            }
+            if (e.bound != TT_LOWER && e.score <= alpha) {
+                tt_cutoffs++;
+                return -alpha;
+            }
+        }
+        hint = e.move;
+    }
+    if (!is_helper && d == 0 && depth > 1)
+        hint = principal_var[0];
+
+    init_picker(&pk, bp, p, d, hint, ms);
+    while ((m = next_move(&pk)) != MOVE_END) {
+        pv[d] = m;
+        apply(bp, m);
+        if (pk.tried == 1 || left == 1) {
+            val = negamax(bp, 1 - p, d + 1, left - 1, pv, -beta, -alpha, pk.end);
+        } else {
+            /* Ties must get through the scout when play is randomized */
+            int lo = randomized ? alpha - 1 : alpha;
+            int r = late_move(&pk, m, left) ? lmr_reduction : 0;
+            val = negamax(bp, 1 - p, d + 1, left - 1 - r, pv, -(lo + 1), -lo, pk.end);
+            if (r > 0 && val != PRUNED)
+                val = negamax(bp, 1 - p, d + 1, left - 1, pv, -(lo + 1), -lo, pk.end);
+            if (val != PRUNED && val < beta)
+                val = negamax(bp, 1 - p, d + 1, left - 1, pv, -beta, -lo, pk.end);
+        }
+        undo(bp);
+        if (val == PRUNED)
+            continue;
+        if (val >= beta) {
+            note_cutoff(p, d, left, m);
+            if (!stopped())
+                tt_store(board_key(bp), left, TT_LOWER, beta, m);
+            return PRUNED;
+        }
+        if (val > alpha || (val == alpha && randomized && (rand() & 0x100))) {
+            for (int i = d; i < d + left; i++)
+                pvar[i] = pv[i];
+            alpha = val;
+            best = m;
+        }
+    }
+    if (stopped())
+        return PRUNED;
+    tt_store(board_key(bp), left, alpha > alpha0 ? TT_EXACT : TT_UPPER,
+             alpha, best);
+    return -alpha;
+}
+
+/* Hand the statistics of a helper over to the thread that collects them. */
+static void flush_stats(struct helper *h)
+{
+    pthread_mutex_lock(&helpers_lock);
+    h->nodes += nodes;
+    h->jumpgens += jumpgens;
+    h->stepgens += stepgens;
+    h->jumptot += jumptot;
+    h->steptot += steptot;
+    h->tt_probes += tt_probes;
+    h->tt_hits += tt_hits;
+    h->tt_cutoffs += tt_cutoffs;
+    pthread_mutex_unlock(&helpers_lock);
+    nodes = jumpgens = stepgens = jumptot = steptot = 0;
+    tt_probes = tt_hits = tt_cutoffs = 0;
+}
+
+static void *helper_main(void *arg)
+{
+    struct helper *h = arg;
+
+    is_helper = 1;
+    pthread_mutex_lock(&helpers_lock);
+    for (;;) {
+        while (!helpers_quit
+               && (helpers_idle || atomic_load(&helpers_job) == helper_job))
+            pthread_cond_wait(&helpers_wake, &helpers_lock);
+        if (helpers_quit)
+            break;
+        helper_job = atomic_load(&helpers_job);
+        copybd(&helpers_root, &h->board);
+        helpers_busy++;
+        pthread_mutex_unlock(&helpers_lock);
+
+        Player p = player_to_move(&h->board);
+        for (int dd = 1; !stopped(); dd++) {
+            int least = atomic_load(&helpers_depth) + h->odd;
+            if (dd < least)
+                dd = least;
+            if (dd > MAXPLY)
+                break;
+            negamax(&h->board, p, 0, dd, h->pv, -MAXEVAL, MAXEVAL, h->stack);
+            flush_stats(h);
+        }
+        pthread_mutex_lock(&helpers_lock);
+        if (--helpers_busy == 0)
+            pthread_cond_signal(&helpers_done);
+    }
+    pthread_mutex_unlock(&helpers_lock);
+    return NULL;
+}
+
+/* End the helper threads, abandoning any job they are working on. */
+static void end_helpers(void)
+{
+    pthread_mutex_lock(&helpers_lock);
+    helpers_quit = 1;
+    atomic_fetch_add(&helpers_job, 1);
+    pthread_cond_broadcast(&helpers_wake);
+    pthread_mutex_unlock(&helpers_lock);
+    for (int i = 0; i < nhelpers; i++)
+        if (helpers[i].running)
+            pthread_join(helpers[i].thread, NULL);
+    helpers_quit = 0;
+    helpers_idle = 1;
+    free(helpers);
+    helpers = NULL;
+    nhelpers = 0;
+}
+
+/*
+ * The signals that stop a search are blocked in the helpers, so that they
+ * are always delivered to the thread that waits for them.
+ */
+int smp_init(int threads)
+{
+    sigset_t block, old;
+
+    end_helpers();
+    if (threads <= 1)
+        return 0;
+    if (threads > MAXTHREADS)
+        return -1;
+    if ((helpers = calloc(threads - 1, sizeof(struct helper))) == NULL)
+        return -1;
+    nhelpers = threads - 1;
+    sigemptyset(&block);
+    sigaddset(&block, SIGHUP);
+    sigaddset(&block, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    for (int i = 0; i < nhelpers; i++) {
+        struct helper *h = &helpers[i];
+        h->odd = i & 1;
+        h->running = pthread_create(&h->thread, NULL, helper_main, h) == 0;
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return 0;
+}
+
+/*
+ * Set the helpers to search the position on a board to at least the
+ * current depth limit.  If they are already searching that position, they
+ * simply carry on, deepening to the new limit if they have not reached it.
+ */
+static void run_helpers(Board *bp)
+{
+    if (nhelpers == 0)
+        return;
+    pthread_mutex_lock(&helpers_lock);
+    if (helpers_idle || board_key(&helpers_root) != board_key(bp)) {
+        copybd(bp, &helpers_root);
+        atomic_store(&helpers_depth, depth);
+        atomic_fetch_add(&helpers_job, 1);
+        helpers_idle = 0;
+        pthread_cond_broadcast(&helpers_wake);
+    } else if (atomic_load(&helpers_depth) < depth) {
+        atomic_store(&helpers_depth, depth);
+    }
+    pthread_mutex_unlock(&helpers_lock);
+}
+
+void smp_idle(void)
+{
+    if (nhelpers == 0)
+        return;
+    pthread_mutex_lock(&helpers_lock);
+    if (!helpers_idle) {
+        helpers_idle = 1;
+        atomic_fetch_add(&helpers_job, 1);
+    }
+    while (helpers_busy > 0)
+        pthread_cond_wait(&helpers_done, &helpers_lock);
+    pthread_mutex_unlock(&helpers_lock);
+}
+
+/* Add the statistics of the helpers so far to those of this thread. */
+static void collect_helpers(void)
+{
+    pthread_mutex_lock(&helpers_lock);
+    for (int i = 0; i < nhelpers; i++) {
+        struct helper *h = &helpers[i];
+        nodes += h->nodes;
+        jumpgens += h->jumpgens;
+        stepgens += h->stepgens;
+        jumptot += h->jumptot;
+        steptot += h->steptot;
+        tt_probes += h->tt_probes;
+        tt_hits += h->tt_hits;
+        tt_cutoffs += h->tt_cutoffs;
+        h->nodes = h->jumpgens = h->stepgens = h->jumptot = h->steptot = 0;
+        h->tt_probes = h->tt_hits = h->tt_cutoffs = 0;
+    }
+    pthread_mutex_unlock(&helpers_lock);
+}
+
+/*
+ * Splitting the root between processes.  The moves at the root are dealt
+ * out in turn to search_procs searchers: this process and one forked child
+ * for each of the others.  Each searcher takes its moves in order, against
+ * the best score found at the root by any of them so far, which is kept in
+ * shared memory and raised by whichever of them improves on it.  The
+ * children report back over pipes and exit.  Each child starts with a copy
+ * of the transposition table, but what it adds to the table is lost.
+ */
+struct slice_result {
+    int found;                            // Some move scored above alpha
+    int cutoff;                           // Some move scored beta or more
+    int score;                            // Best score found, if any
+    int nodes;
+    Move pv[MAXPLY + 1];                  // Line of the best move
+};
+
+static Move split_roots[MAXMOVES];
+
+int split_init(int procs)
+{
+    if (share != NULL)
+        munmap(share, sizeof(*share));
+    share = NULL;
+    search_procs = 1;
+    if (procs <= 1)
+        return 0;
+    if (procs > MAXPROCS)
+        return -1;
+    share = mmap(NULL, sizeof(*share), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (share == MAP_FAILED) {
+        share = NULL;
+        return -1;
+    }
+    atomic_init(&share->alpha, -MAXEVAL);
+    atomic_init(&share->stop, 0);
+    search_procs = procs;
+    return 0;
+}
+
+static void raise_alpha(int val)
+{
+    int cur = atomic_load(&share->alpha);
+
+    while (val > cur && !atomic_compare_exchange_weak(&share->alpha, &cur, val))
+        ;
+}
+
+/*
+ * Search the root moves roots[k], roots[k + search_procs], ... of the
+ * position on a board, with the window (alpha, beta) narrowed by the
+ * shared alpha.  As in negamax, the first move is searched with the full
+ * window and the rest with a scout first.
+ */
+static void search_slice(Board *bp, Move *roots, int n, int k,
+                         int alpha, int beta, Move *stack,
+                         struct slice_result *res)
+{
+    Player p = player_to_move(bp);
+    Move pv[MAXPLY + 1];
+    int first = 1;
+
+    res->found = res->cutoff = 0;
+    for (int i = k; i < n && !stopped(); i += search_procs) {
+        int a = atomic_load(&share->alpha);
+        int val;
+
+        if (a < alpha)
+            a = alpha;
+        if (a >= beta)
+            break;
+        pv[0] = roots[i];
+        apply(bp, roots[i]);
+        if (first || depth == 1) {
+            val = negamax(bp, 1 - p, 1, depth - 1, pv, -beta, -a, stack);
+        } else {
+            val = negamax(bp, 1 - p, 1, depth - 1, pv, -(a + 1), -a, stack);
+            if (val != PRUNED && val < beta)
+                val = negamax(bp, 1 - p, 1, depth - 1, pv, -beta, -a, stack);
+        }
+        undo(bp);
+        first = 0;
+        if (val == PRUNED)
+            continue;
+        if (val >= beta) {
+            res->cutoff = 1;
+            raise_alpha(beta);
+            break;
+        }
+        res->found = 1;
+        res->score = val;
+        for (int j = 0; j < depth; j++)
+            res->pv[j] = pv[j];
+        raise_alpha(val);
+    }
+}
+
+/* Read the result of a child, stopping the children if a signal says so. */
+static int read_result(int fd, struct slice_result *res)
+{
+    char *buf = (char *)res;
+    size_t got = 0;
+
+    while (got < sizeof(*res)) {
+        ssize_t r = read(fd, buf + got, sizeof(*res) - got);
+        if (r > 0) {
+            got += r;
+        } else if (r < 0 && errno == EINTR) {
+            if (stop_search)
+                atomic_store(&share->stop, 1);
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Search the root of a position, split between processes.  The result is
+ * as from negamax: PRUNED if the score is at least beta, otherwise the
+ * negation of the score, or of alpha if the score is no more than that.
+ */
+static int split_root(Board *bp, int alpha, int beta, Move *stack)
+{
+    struct slice_result res[search_procs];
+    pid_t pid[search_procs];
+    int fd[search_procs];
+    struct picker pk;
+    Move m;
+    int n = 0;
+
+    init_picker(&pk, bp, player_to_move(bp), 0,
+                depth > 1 ? principal_var[0] : MOVE_END, stack);
+    while ((m = next_move(&pk)) != MOVE_END && n < MAXMOVES)
+        split_roots[n++] = m;
+
+    atomic_store(&share->alpha, alpha);
+    atomic_store(&share->stop, 0);
+    for (int k = 1; k < search_procs; k++) {
+        int pfd[2];
+        pid[k] = -1;
+        if (pipe(pfd) < 0)
+            continue;
+        if ((pid[k] = fork()) == 0) {
+            close(pfd[0]);
+            nodes = 0;
+            search_slice(bp, split_roots, n, k, alpha, beta, stack, &res[k]);
+            res[k].nodes = nodes;
+            if (write(pfd[1], &res[k], sizeof(res[k])) < 0)
+                _exit(EXIT_FAILURE);
+            _exit(EXIT_SUCCESS);
+        }
+        close(pfd[1]);
+        fd[k] = pfd[0];
+        if (pid[k] < 0)
+            close(fd[k]);
+    }
+
+    search_slice(bp, split_roots, n, 0, alpha, beta, stack, &res[0]);
+    for (int k = 1; k < search_procs; k++) {
+        if (stop_search)
+            atomic_store(&share->stop, 1);
+        int ok = pid[k] > 0 && read_result(fd[k], &res[k]) == 0;
+        if (pid[k] > 0) {
+            close(fd[k]);
+            while (waitpid(pid[k], NULL, 0) < 0 && errno == EINTR)
+                ;
+        }
+        if (ok)
+            nodes += res[k].nodes;
+        else if (!stopped())
+            search_slice(bp, split_roots, n, k, alpha, beta, stack, &res[k]);
+    }
+    if (stopped())
+        return PRUNED;
+
+    int best = -1;
+    for (int k = 0; k < search_procs; k++) {
+        if (res[k].cutoff)
+            return PRUNED;
+        if (res[k].found && (best < 0 || res[k].score > res[best].score))
+            best = k;
+    }
+    if (best < 0)
+        return -alpha;
+    for (int j = 0; j < depth; j++)
+        principal_var[j] = res[best].pv[j];
+    return -res[best].score;
+}
+
+int bestmove(Board *bp, Player p, int d, Move *pvar, int alpha, int beta)
+{
+    return negamax(bp, p, d, depth - d, pvar, alpha, beta, default_stack);
+}
+
+int search(Board *bp, Move *stack)
+{
+    return search_window(bp, stack, -MAXEVAL, MAXEVAL);
+}
+
+int search_window(Board *bp, Move *stack, int alpha, int beta)
+{
+    int mark = checkpoint(bp);
+
+    if (root_key != board_key(bp) || root_jumps == 0) {
+        root_key = board_key(bp);
+        root_jumps = gen_jumps_with_paths(bp, root_moves, root_paths, MAXMOVES);
+    }
+    int val;
+    if (search_procs > 1 && depth > 1 && !game_over(bp)) {
+        smp_idle();
+        val = split_root(bp, alpha, beta, stack);
+    } else {
+        /* An abandoned search leaves the previous line in place */
+        Move pv[MAXPLY + 1];
+        for (int j = 0; j <= MAXPLY; j++)
+            pv[j] = principal_var[j];
+        run_helpers(bp);
+        val = negamax(bp, player_to_move(bp), 0, depth, pv, alpha, beta, stack);
+        collect_helpers();
+        if (stop_search)
+            smp_idle();
+        if (!stop_search)
+            for (int j = 0; j < depth; j++)
+                principal_var[j] = pv[j];
+    }
+
+    undo_to(bp, mark);
+    return val == PRUNED ? beta : -val;
+}
+
+int root_path(Board *bp, Move m, Hoppath *path)
+{
+    if (root_key == board_key(bp)) {
+        for (int i = 0; i < root_jumps; i++) {
+            if (root_moves[i] == m) {
+                *path = root_paths[i];
+                return 0;
+            }
+        }
+    }
+    return move_path(bp, m, path);
+}
@@ -0,0 +1,370 @@
+/*
+ * Game board: representation, construction, and application of moves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+/* Directions of movement: E, NE, N, W, SW, S (in row/column terms). */
+int rdirect[] = { 0, -1, -1,  0,  1,  1 };
+int cdirect[] = { 1,  1,  0, -1, -1,  0 };
+
+Bitboard onboard;
+Bitboard home[2];
+Bitboard goal[2];
+Bitboard swapzone[2];
+Bitboard ahead[2][NDIAGS];
+
+static int mirror_sq[128];                // Reflection of each square
+
+uint64_t zobrist[2][128];
+uint64_t zobrist_side;
+
+/*
+ * Initial values of the incremental evaluation terms, and the sums of
+ * row + column and of |row - column| over the cells of X's home triangle.
+ * O's home triangle is the reflection of X's through the centre of the
+ * board.
+ */
+#define INIT_CENTER 18
+#define INIT_PROGRESS 20
+#define HOME_CENTER 14
+
+/*
+ * Generator for the Zobrist keys (splitmix64).  A fixed seed makes keys
+ * reproducible from run to run, and the same in every process.
+ */
+static uint64_t next_key(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Fill in the constant masks describing the geometry of the board, and the
+ * Zobrist keys.
+ */
+static void init_masks(void)
+{
+    uint64_t state = 0;
+
+    for (Player p = X; p <= O; p++)
+        for (int s = 0; s < 128; s++)
+            zobrist[p][s] = next_key(&state);
+    zobrist_side = next_key(&state);
+
+    for (int r = 0; r < BDSIZE; r++) {
+        for (int c = 0; c < BDSIZE; c++) {
+            Bitboard b = BIT(SQUARE(r, c));
+            onboard |= b;
+            if (r + c <= 3)
+                home[X] |= b;
+            if (r + c >= 13)
+                home[O] |= b;
+            if (r + c >= 12)
+                swapzone[X] |= b;
+            if (r + c <= 4)
+                swapzone[O] |= b;
+            mirror_sq[SQUARE(r, c)] = SQUARE(c, r);
+            for (int k = 0; k < NDIAGS; k++) {
+                if (r + c >= k)
+                    ahead[X][k] |= b;
+                if (r + c <= k)
+                    ahead[O][k] |= b;
+            }
+        }
+    }
+    goal[X] = home[O];
+    goal[O] = home[X];
+}
+
+/* Compute the Zobrist key of a position from scratch. */
+static uint64_t compute_key(Board *bp)
+{
+    uint64_t key = (bp->player == O) ? zobrist_side : 0;
+
+    for (Player p = X; p <= O; p++) {
+        Bitboard pieces = bp->occ[p];
+        while (pieces)
+            key ^= zobrist[p][bb_pop(&pieces)];
+    }
+    return key;
+}
+
+#ifdef DEBUG
+/*
+ * Catch any drift of the incrementally maintained key, or of the piece
+ * lists from the occupancy masks.
+ */
+static void check_board(Board *bp)
+{
+    if (bp->key != compute_key(bp)) {
+        fprintf(stderr, "Stale board key %016llx (expected %016llx) at move %d\n",
+                (unsigned long long)bp->key,
+                (unsigned long long)compute_key(bp), bp->moveno);
+        abort();
+    }
+    for (Player p = X; p <= O; p++) {
+        Bitboard listed = 0;
+        for (int i = 0; i < NPIECES; i++) {
+            int s = bp->pieces[p][i];
+            if (bp->index[s] != i) {
+                fprintf(stderr, "Piece list out of step at move %d\n", bp->moveno);
+                abort();
+            }
+            listed |= BIT(s);
+        }
+        if (listed != bp->occ[p]) {
+            fprintf(stderr, "Piece list out of step at move %d\n", bp->moveno);
+            abort();
+        }
+    }
+}
+#else
+#define check_board(bp)
+#endif
+
+/*
+ * Boards returned by newbd come from a small fixed pool, so that making and
+ * discarding temporary boards costs no heap traffic.  Free pool boards are
+ * chained through their first word.  When the pool is exhausted, newbd
+ * falls back on malloc.
+ */
+static Board pool[BDPOOL];
+static Board *pool_free;
+static int pool_used;                     // Boards ever taken from pool
+
+Board *initbd(Board *bp)
+{
+    if (!onboard)
+        init_masks();
+    return setbd(bp, home[X], home[O], X);
+}
+
+Board *setbd(Board *bp, Bitboard xs, Bitboard os, Player p)
+{
+    if (!onboard)
+        init_masks();
+    bp->occ[X] = xs;
+    bp->occ[O] = os;
+    bp->player = p;
+    bp->moveno = 0;
+    bp->hp = 0;
+    bp->progress[X] = -INIT_PROGRESS;
+    bp->progress[O] = 2 * (BDSIZE - 1) * NPIECES - INIT_PROGRESS;
+    bp->center[X] = bp->center[O] = INIT_CENTER + HOME_CENTER;
+    for (Player q = X; q <= O; q++) {
+        Bitboard b = bp->occ[q];
+        for (int i = 0; b; i++) {
+            int s = bb_pop(&b);
+            int advance = SQ_ROW(s) + SQ_COL(s);
+            bp->progress[q] += (q == X) ? advance : -advance;
+            bp->center[q] -= abs(SQ_ROW(s) - SQ_COL(s));
+            bp->pieces[q][i] = s;
+            bp->index[s] = i;
+        }
+    }
+    bp->key = compute_key(bp);
+    return bp;
+}
+
+Board *newbd()
+{
+    Board *bp;
+
+    if (pool_free != NULL) {
+        bp = pool_free;
+        pool_free = *(Board **)bp;
+    } else if (pool_used < BDPOOL) {
+        bp = &pool[pool_used++];
+    } else if ((bp = malloc(sizeof(Board))) == NULL) {
+        return NULL;
+    }
+    return initbd(bp);
+}
+
+void freebd(Board *bp)
+{
+    if (bp == NULL)
+        return;
+    if (bp >= pool && bp < pool + BDPOOL) {
+        *(Board **)bp = pool_free;
+        pool_free = bp;
+    } else {
+        free(bp);
+    }
+}
+
+Board *copybd(Board *obp, Board *bp)
+{
+    memcpy(bp, obp, offsetof(Board, history) + obp->hp * sizeof(Move));
+    return bp;
+}
+
+int move_number(Board *bp)
+{
+    return bp->moveno;
+}
+
+Player player_to_move(Board *bp)
+{
+    return bp->player;
+}
+
+uint64_t board_key(Board *bp)
+{
+    return bp->key;
+}
+
+int row_from(Move m)
+{
+    return (m >> 12) & 0xf;
+}
+
+int row_to(Move m)
+{
+    return (m >> 4) & 0xf;
+}
+
+int col_from(Move m)
+{
+    return (m >> 8) & 0xf;
+}
+
+int col_to(Move m)
+{
+    return m & 0xf;
+}
+
+/*
+ * Update the evaluation terms of player p for a piece of that player
+ * moving from (fr, fc) to (tr, tc).
+ */
+static void track(Board *bp, Player p, int fr, int fc, int tr, int tc)
+{
+    int advance = (tr + tc) - (fr + fc);
+
+    bp->progress[p] += (p == X) ? advance : -advance;
+    bp->center[p] += abs(fr - fc) - abs(tr - tc);
+}
+
+/*
+ * Exchange the contents of the two cells involved in a move.  For each
+ * player this is at most one XOR of the occupancy mask, plus an update of
+ * one piece list entry.  An ordinary move exchanges a piece with an empty
+ * cell; a step onto an opponent's piece (only legal near the mover's goal)
+ * exchanges the two pieces.  Because the exchange is its own inverse, it
+ * serves for both apply and undo, and undo restores the board exactly even
+ * if the move was not legal.  The Zobrist key is updated along with the
+ * masks.
+ */
+static void exchange(Board *bp, Move m)
+{
+    int fr = row_from(m), fc = col_from(m);
+    int tr = row_to(m), tc = col_to(m);
+    int sf = SQUARE(fr, fc), st = SQUARE(tr, tc);
+    int ifrom = bp->index[sf], ito = bp->index[st];
+    Bitboard from = BIT(sf), to = BIT(st);
+
+    for (Player p = X; p <= O; p++) {
+        Bitboard b = bp->occ[p] & (from | to);
+        if (b == from) {
+            track(bp, p, fr, fc, tr, tc);
+            bp->pieces[p][ifrom] = st;
+            bp->index[st] = ifrom;
+        } else if (b == to) {
+            track(bp, p, tr, tc, fr, fc);
+            bp->pieces[p][ito] = sf;
+            bp->index[sf] = ito;
+        } else {
+            continue;
+        }
+        bp->occ[p] ^= from | to;
+        bp->key ^= zobrist[p][sf] ^ zobrist[p][st];
+    }
+}
+
+void apply(Board *bp, Move m)
+{
+    bp->moveno++;
+    bp->player = 1 - bp->player;
+    bp->key ^= zobrist_side;
+    if (bp->hp >= MAXHIST) {
+        fprintf(stderr, "Move log full at move %d\n", bp->moveno);
+        abort();
+    }
+    bp->history[bp->hp++] = m;
+    if (!IS_PASS(m))
+        exchange(bp, m);
+    check_board(bp);
+}
+
+void undo(Board *bp)
+{
+    if (bp->hp == 0)
+        return;
+    Move m = bp->history[--bp->hp];
+    bp->moveno--;
+    bp->player = 1 - bp->player;
+    bp->key ^= zobrist_side;
+    if (!IS_PASS(m))
+        exchange(bp, m);
+    check_board(bp);
+}
+
+int checkpoint(Board *bp)
+{
+    return bp->hp;
+}
+
+void undo_to(Board *bp, int mark)
+{
+    while (bp->hp > mark)
+        undo(bp);
+}
+
+/*
+ * The board is symmetric about the axis joining the two home triangles,
+ * which exchanges rows and columns.  The set of directions, the home and
+ * swap zones, and both evaluation terms are all preserved by it.
+ */
+Bitboard mirror_bb(Bitboard b)
+{
+    Bitboard m = 0;
+
+    if (!onboard)
+        init_masks();
+    while (b)
+        m |= BIT(mirror_sq[bb_pop(&b)]);
+    return m;
+}
+
+Move mirror_move(Move m)
+{
+    return (m & MOVE_PLAYER)
+         | (col_from(m) << 12) | (row_from(m) << 8)
+         | (col_to(m) << 4) | row_to(m);
+}
+
+int canonical_position(Board *bp, Bitboard occ[2])
+{
+    Bitboard mx = mirror_bb(bp->occ[X]);
+    Bitboard mo = mirror_bb(bp->occ[O]);
+
+    if (mx < bp->occ[X] || (mx == bp->occ[X] && mo < bp->occ[O])) {
+        occ[X] = mx;
+        occ[O] = mo;
+        return 1;
+    }
+    occ[X] = bp->occ[X];
+    occ[O] = bp->occ[O];
+    return 0;
+}
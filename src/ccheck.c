@@ -12,6 +12,7 @@
 #include <time.h>
 
 #include "ccheck.h"
+#include "board.h"
 #include "debug.h"
 
 /*
@@ -25,6 +26,11 @@
  *   -a <num>     set average time per move (in seconds)
  *   -i <file>    initialize from saved game score
  *   -o <file>    specify transcript file name
+ *   -H <num>     set transposition table size (in megabytes, 0 for none)
+ *   -R <num>     set reduction of late moves (in plies, 0 for none)
+ *   -L <num>     set number of moves searched before late move reductions
+ *   -T <num>     set number of threads for the engine to search with
+ *   -P <num>     set number of processes to split the engine's search between
  */
 
 /* Global variables for signal handling */
@@ -242,42 +248,50 @@ static int start_engine(Board *bp)
     return 0;
 }
 
-/* Send move to display and wait for acknowledgement */
-static int send_move_to_display(Board *bp, Move m)
+/* Send the notation of a move to display and wait for acknowledgement */
+static int send_notation_to_display(const char *notation)
 {
-    fprintf(stderr, "DEBUG: send_move_to_display: starting, move=0x%x\n", m);
+    fprintf(stderr, "DEBUG: send_notation_to_display: starting, move=%s\n", notation);
     if (!display_out) {
-        fprintf(stderr, "DEBUG: send_move_to_display: display_out is NULL\n");
+        fprintf(stderr, "DEBUG: send_notation_to_display: display_out is NULL\n");
         return -1;
     }
 
-    fprintf(stderr, "DEBUG: send_move_to_display: sending move to display (pid %d)\n", display_pid);
-    fprintf(display_out, ">");
-    print_move(bp, m, display_out);
-    fprintf(display_out, "\n");
+    fprintf(stderr, "DEBUG: send_notation_to_display: sending move to display (pid %d)\n", display_pid);
+    fprintf(display_out, ">%s\n", notation);
     fflush(display_out);
 
-    fprintf(stderr, "DEBUG: send_move_to_display: sending SIGHUP to display\n");
+    fprintf(stderr, "DEBUG: send_notation_to_display: sending SIGHUP to display\n");
     if (kill(display_pid, SIGHUP) < 0) {
         perror("kill display SIGHUP");
-        fprintf(stderr, "DEBUG: send_move_to_display: failed to send SIGHUP\n");
+        fprintf(stderr, "DEBUG: send_notation_to_display: failed to send SIGHUP\n");
         return -1;
     }
 
     /* Wait for acknowledgement */
-    fprintf(stderr, "DEBUG: send_move_to_display: waiting for acknowledgement\n");
+    fprintf(stderr, "DEBUG: send_notation_to_display: waiting for acknowledgement\n");
     char line[256];
     if (fgets(line, sizeof(line), display_in) == NULL) {
-        fprintf(stderr, "DEBUG: send_move_to_display: failed to read acknowledgement (display may have crashed)\n");
+        fprintf(stderr, "DEBUG: send_notation_to_display: failed to read acknowledgement (display may have crashed)\n");
         return -1;
     }
-    fprintf(stderr, "DEBUG: send_move_to_display: received acknowledgement: '%s'\n", line);
+    fprintf(stderr, "DEBUG: send_notation_to_display: received acknowledgement: '%s'\n", line);
 
     return 0;
 }
 
+/* Send move to display and wait for acknowledgement */
+static int send_move_to_display(Move m, const Hoppath *path)
+{
+    char notation[MOVE_TEXT];
+
+    fprintf(stderr, "DEBUG: send_move_to_display: starting, move=0x%x\n", m);
+    sprint_move_with_path(m, path, notation);
+    return send_notation_to_display(notation);
+}
+
 /* Request move from display */
-static Move get_move_from_display(Board *bp)
+static Move get_move_from_display(Board *bp, Hoppath *path)
 {
     fprintf(stderr, "DEBUG: get_move_from_display: starting\n");
     if (!display_out) {
@@ -296,27 +310,21 @@ static Move get_move_from_display(Board *bp)
     }
 
     fprintf(stderr, "DEBUG: get_move_from_display: waiting for move from display\n");
-    Move m = read_move_from_pipe(display_in, bp);
+    Move m = read_move_with_path(display_in, bp, path);
     fprintf(stderr, "DEBUG: get_move_from_display: received move (0x%x)\n", m);
     return m;
 }
 
 /* Send move to engine */
-static int send_move_to_engine(Board *bp, Move m)
+static int send_move_to_engine(Move m, const Hoppath *path)
 {
     if (!engine_out) return -1;
 
-    /* Create a copy of the board for print_move (it needs pre-move state) */
-    Board *temp_bp = newbd();
-    copybd(bp, temp_bp);
-
     fprintf(engine_out, ">");
-    print_move(temp_bp, m, engine_out);
+    print_move_with_path(m, path, engine_out);
     fprintf(engine_out, "\n");
     fflush(engine_out);
 
-    /* Note: We can't easily free temp_bp, but it's just for printing */
-
     if (kill(engine_pid, SIGHUP) < 0) {
         perror("kill engine SIGHUP");
         return -1;
@@ -332,7 +340,7 @@ static int send_move_to_engine(Board *bp, Move m)
 }
 
 /* Request move from engine */
-static Move get_move_from_engine(Board *bp)
+static Move get_move_from_engine(Board *bp, Hoppath *path)
 {
     debug("get_move_from_engine: starting");
     if (!engine_out) {
@@ -355,13 +363,13 @@ static Move get_move_from_engine(Board *bp)
             (void*)engine_in, feof(engine_in), ferror(engine_in));
     
     /* Peek at what's coming from the engine before reading */
-    fprintf(stderr, "DEBUG: get_move_from_engine: about to call read_move_from_pipe\n");
+    fprintf(stderr, "DEBUG: get_move_from_engine: about to call read_move_with_path\n");
     fprintf(stderr, "DEBUG: get_move_from_engine: current board state - move_number=%d, player_to_move=%d\n",
             move_number(bp), player_to_move(bp));
     
-    /* Read move directly - read_move_from_pipe will block until data is available */
-    Move m = read_move_from_pipe(engine_in, bp);
-    fprintf(stderr, "DEBUG: get_move_from_engine: read_move_from_pipe returned (0x%x)\n", m);
+    /* Read move directly - read_move_with_path will block until data is available */
+    Move m = read_move_with_path(engine_in, bp, path);
+    fprintf(stderr, "DEBUG: get_move_from_engine: read_move_with_path returned (0x%x)\n", m);
     if (m == 0) {
         fprintf(stderr, "DEBUG: get_move_from_engine: move is 0, checking for errors\n");
         if (feof(engine_in)) {
@@ -385,146 +393,75 @@ static int read_game_history(Board *bp, const char *filename)
         return -1;
     }
 
-    char line[256];
-    int move_count = 0;
-    while (fgets(line, sizeof(line), f)) {
-        /* Skip empty lines */
-        if (line[0] == '\n' || line[0] == '\0') {
-            fprintf(stderr, "DEBUG: read_game_history: skipping empty line\n");
-            continue;
-        }
-
-        /* Parse line format: "N. white:MOVE" or "N. ... black:MOVE" */
-        char *colon = strchr(line, ':');
-        if (!colon) {
-            fprintf(stderr, "DEBUG: read_game_history: skipping line without colon: %s", line);
-            continue;
-        }
-
-        /* Determine which player this move is for based on the line format */
-        /* Format is either "N. white:MOVE" or "N. ... black:MOVE" */
-        Player move_player;
-        if (strstr(line, "white:")) {
-            move_player = X;  /* X is white */
-        } else if (strstr(line, "black:")) {
-            move_player = O;  /* O is black */
-        } else {
-            fprintf(stderr, "DEBUG: read_game_history: cannot determine player from line: %s", line);
-            continue;
-        }
-        
-        /* Extract move part (after colon) */
-        char *move_str = colon + 1;
-        move_count++;
-        fprintf(stderr, "DEBUG: read_game_history: processing move %d, raw line: %s", move_count, line);
-        
-        /* Remove newline and carriage return if present */
-        char *newline = strchr(move_str, '\n');
-        if (newline) *newline = '\0';
-        char *carriage = strchr(move_str, '\r');
-        if (carriage) *carriage = '\0';
-        
-        /* Trim leading whitespace */
-        while (*move_str == ' ' || *move_str == '\t') {
-            move_str++;
-        }
-        
-        /* Trim trailing whitespace */
-        char *end = move_str + strlen(move_str) - 1;
-        while (end > move_str && (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')) {
-            *end = '\0';
-            end--;
-        }
-        
-        /* Skip empty moves */
-        if (*move_str == '\0') {
-            fprintf(stderr, "DEBUG: read_game_history: skipping empty move string\n");
-            continue;
-        }
-
-        /* Verify it's the correct player's turn */
-        Player current_player = player_to_move(bp);
-        if (current_player != move_player) {
-            fprintf(stderr, "DEBUG: read_game_history: wrong player - expected %d, got %d for move '%s'\n", 
-                    current_player, move_player, move_str);
-            /* This might be okay if the file format is inconsistent, but log it */
-        }
-
-        /* Create a temporary file-like stream for the move */
-        /* read_move_from_pipe expects a newline-terminated move, so we need to add one */
-        /* Format should match what print_move outputs: "white:MOVE" or "black:MOVE" */
-        char move_with_prefix[256];
-        if (move_player == X) {
-            snprintf(move_with_prefix, sizeof(move_with_prefix), "white:%s\n", move_str);
-        } else {
-            snprintf(move_with_prefix, sizeof(move_with_prefix), "black:%s\n", move_str);
-        }
-        
-        FILE *tmp = fmemopen(move_with_prefix, strlen(move_with_prefix), "r");
-        if (!tmp) {
-            perror("fmemopen");
-            fclose(f);
-            return -1;
-        }
+    /* Slurp the whole file, so that the moves can be replayed in one go */
+    size_t len = 0, cap = 4096;
+    char *text = malloc(cap);
+    while (text) {
+        len += fread(text + len, 1, cap - len - 1, f);
+        if (len < cap - 1)
+            break;
+        char *bigger = realloc(text, cap *= 2);
+        if (!bigger)
+            free(text);
+        text = bigger;
+    }
+    if (!text || ferror(f)) {
+        perror("read history file");
+        free(text);
+        fclose(f);
+        return -1;
+    }
+    text[len] = '\0';
+    fclose(f);
 
-        fprintf(stderr, "DEBUG: read_game_history: calling read_move_from_pipe with move '%s' (board state: move_num=%d, player=%d)\n", 
-                move_with_prefix, move_number(bp), player_to_move(bp));
-        Move m = read_move_from_pipe(tmp, bp);
-        fclose(tmp);
+    size_t notation_size = (size_t)MAXHIST * MOVE_TEXT;
+    char *notation = malloc(notation_size);
+    if (!notation) {
+        perror("malloc");
+        free(text);
+        return -1;
+    }
 
-        if (m == 0) {
-            /* EOF or invalid move - stop reading */
-            fprintf(stderr, "DEBUG: read_game_history: read_move_from_pipe returned 0 for move %d: '%s'\n", move_count, move_str);
+    /* Parse, check and apply all the moves, collecting their notation */
+    int first_move = move_number(bp);
+    const char *stop;
+    int why;
+    int move_count = replay_moves(bp, text, MAXGAME - first_move, NULL,
+                                  notation, notation_size, &stop, &why);
+    int stop_len = strcspn(stop, "\n");
+    switch (why) {
+        case REPLAY_ILLEGAL:
+            fprintf(stderr, "Warning: Illegal move in history file: %.*s\n", stop_len, stop);
             break;
-        }
-        
-        fprintf(stderr, "DEBUG: read_game_history: successfully parsed move %d: '%s' -> 0x%x\n", move_count, move_str, m);
-
-        /* Verify move is legal before proceeding */
-        if (!legal_move(m, bp)) {
-            fprintf(stderr, "Warning: Illegal move in history file: %s\n", move_str);
+        case REPLAY_LIMIT:
+            fprintf(stderr, "Warning: History file has more than %d moves, ignoring the rest from: %.*s\n",
+                    MAXGAME - first_move, stop_len, stop);
             break;
-        }
-
-        /* Determine player and move number BEFORE applying move */
-        Player p = player_to_move(bp);
-        int move_num_before = move_number(bp);
-
-        /* Capture print_move output BEFORE applying move (print_move needs pre-move board state) */
-        char move_buffer[256] = {0};
-        FILE *capture_stream = fmemopen(move_buffer, sizeof(move_buffer) - 1, "w");
-        if (capture_stream) {
-            print_move(bp, m, capture_stream);
-            fclose(capture_stream);
-        }
+        case REPLAY_FULL:
+            fprintf(stderr, "Warning: Too many moves in history file to record, ignoring the rest from: %.*s\n",
+                    stop_len, stop);
+            break;
+    }
 
-        /* Strip player prefix (e.g., "black:" or "white:") if present */
-        char *move_str_for_display = move_buffer;
-        char *move_colon = strchr(move_buffer, ':');
-        if (move_colon && (strncmp(move_buffer, "black:", 6) == 0 || strncmp(move_buffer, "white:", 6) == 0)) {
-            move_str_for_display = move_colon + 1;  /* Skip past the colon */
-        }
+    /* Pass the moves on to the display and the transcript */
+    char *line = notation;
+    for (int i = 0; i < move_count; i++) {
+        char *newline = strchr(line, '\n');
+        *newline = '\0';
 
-        /* Update display BEFORE applying move (print_move needs pre-move board state) */
         if (use_display && display_out) {
-            /* Create a copy of the board for print_move (it needs pre-move state) */
-            Board *temp_bp = newbd();
-            copybd(bp, temp_bp);
-            if (send_move_to_display(temp_bp, m) < 0) {
-                fprintf(stderr, "Warning: Failed to update display with move %d, continuing anyway\n", move_count);
+            if (send_notation_to_display(line) < 0) {
+                fprintf(stderr, "Warning: Failed to update display with move %d, continuing anyway\n", i + 1);
             }
-            /* Note: We can't easily free temp_bp, but it's just for printing */
         }
 
-        apply(bp, m);
-        setclock(player_to_move(bp) == X ? O : X);
+        Player p = (strncmp(line, "black:", 6) == 0) ? O : X;
+        setclock(p);
 
         /* Write to transcript if in use */
-        if (transcript_file && move_str_for_display) {
-            /* Write formatted move to transcript */
-            /* Move numbers: move_number increments after each move, so we need to calculate the move pair number */
-            /* For both white and black moves in the same pair, we use: (move_num_before / 2) + 1 */
-            int transcript_move_num = (move_num_before / 2) + 1;
+        if (transcript_file) {
+            /* Move numbers: for both white and black moves in the same pair, we use: (move number / 2) + 1 */
+            int transcript_move_num = ((first_move + i) / 2) + 1;
             if (p == X) {
                 /* White move: format is "N. white:MOVE" */
                 fprintf(transcript_file, "%d. white:", transcript_move_num);
@@ -532,13 +469,15 @@ static int read_game_history(Board *bp, const char *filename)
                 /* Black move: format is "N. ... black:MOVE" where N is same as white's move number */
                 fprintf(transcript_file, "%d. ... black:", transcript_move_num);
             }
-            fprintf(transcript_file, "%s", move_str_for_display);  /* Write only the move notation, not the player prefix */
-            fprintf(transcript_file, "\n");
+            fprintf(transcript_file, "%s\n", strchr(line, ':') + 1);  /* Write only the move notation, not the player prefix */
             fflush(transcript_file);
         }
+
+        line = newline + 1;
     }
 
-    fclose(f);
+    free(notation);
+    free(text);
     fprintf(stderr, "DEBUG: read_game_history: read %d moves total\n", move_count);
     return 0;
 }
@@ -563,7 +502,7 @@ int ccheck(int argc, char *argv[])
     play_black = 0;
 
     /* Parse command line arguments */
-    while ((opt = getopt(argc, argv, "wbrvdta:i:o:")) != -1) {
+    while ((opt = getopt(argc, argv, "wbrvdta:i:o:H:R:L:T:P:")) != -1) {
         switch (opt) {
             case 'w':
                 play_white = 1;
@@ -594,8 +533,31 @@ int ccheck(int argc, char *argv[])
             case 'o':
                 output_file = optarg;
                 break;
+            case 'H':
+                tt_megabytes = atoi(optarg);
+                break;
+            case 'R':
+                lmr_reduction = atoi(optarg);
+                break;
+            case 'L':
+                lmr_moves = atoi(optarg);
+                break;
+            case 'T':
+                search_threads = atoi(optarg);
+                if (search_threads < 1 || search_threads > MAXTHREADS) {
+                    fprintf(stderr, "Number of threads must be from 1 to %d\n", MAXTHREADS);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P':
+                search_procs = atoi(optarg);
+                if (search_procs < 1 || search_procs > MAXPROCS) {
+                    fprintf(stderr, "Number of processes must be from 1 to %d\n", MAXPROCS);
+                    return EXIT_FAILURE;
+                }
+                break;
             default:
-                fprintf(stderr, "Usage: %s [-w] [-b] [-r] [-v] [-d] [-t] [-a time] [-i file] [-o file]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-w] [-b] [-r] [-v] [-d] [-t] [-a time] [-i file] [-o file] [-H megabytes] [-R plies] [-L moves] [-T threads] [-P processes]\n", argv[0]);
                 return EXIT_FAILURE;
         }
     }
@@ -625,6 +587,7 @@ int ccheck(int argc, char *argv[])
         if (start_display() < 0) {
             fprintf(stderr, "Failed to start display process\n");
             if (transcript_file) fclose(transcript_file);
+            freebd(bp);
             return EXIT_FAILURE;
         }
     }
@@ -636,6 +599,7 @@ int ccheck(int argc, char *argv[])
             fprintf(stderr, "Failed to read game history\n");
             cleanup_children();
             if (transcript_file) fclose(transcript_file);
+            freebd(bp);
             return EXIT_FAILURE;
         }
         fprintf(stderr, "DEBUG: Finished reading game history\n");
@@ -643,13 +607,12 @@ int ccheck(int argc, char *argv[])
 
     /* Start engine process if needed */
     if (play_white || play_black) {
-        /* Create a copy of the board for the engine */
-        Board *engine_board = newbd();
-        copybd(bp, engine_board);
-        if (start_engine(engine_board) < 0) {
+        /* The engine process gets its own copy of the board from fork() */
+        if (start_engine(bp) < 0) {
             fprintf(stderr, "Failed to start engine process\n");
             cleanup_children();
             if (transcript_file) fclose(transcript_file);
+            freebd(bp);
             return EXIT_FAILURE;
         }
     }
@@ -689,6 +652,12 @@ int ccheck(int argc, char *argv[])
             break;
         }
 
+        /* Stop before the move logs have no room left for a search */
+        if (move_number(bp) >= MAXGAME) {
+            printf("Game stopped after %d moves\n", move_number(bp));
+            break;
+        }
+
         /* Determine whose turn it is */
         Player current_player = player_to_move(bp);
         int is_computer_turn = (current_player == X && play_white) || (current_player == O && play_black);
@@ -697,11 +666,12 @@ int ccheck(int argc, char *argv[])
                 current_player, X, O, play_white, play_black, is_computer_turn);
 
         Move m = 0;
+        Hoppath path;  /* Hops of the move, as played: printed without re-searching */
 
         if (is_computer_turn) {
             fprintf(stderr, "DEBUG: It's computer's turn, requesting move from engine\n");
             /* Get move from engine */
-            m = get_move_from_engine(bp);
+            m = get_move_from_engine(bp, &path);
             if (m == 0) {
                 fprintf(stderr, "Failed to get move from engine\n");
                 break;
@@ -712,16 +682,19 @@ int ccheck(int argc, char *argv[])
             if (tournament_mode) {
                 printf("@@@");
             }
-            print_move(bp, m, stdout);
+            print_move_with_path(m, &path, stdout);
             printf("\n");
             fflush(stdout);
         } else {
             fprintf(stderr, "DEBUG: It's user's turn, getting move\n");
             /* Get move from user */
             if (use_display && !tournament_mode) {
-                m = get_move_from_display(bp);
+                m = get_move_from_display(bp, &path);
             } else {
                 m = read_move_interactive(bp);
+                if (m != 0 && move_path(bp, m, &path) < 0) {
+                    print_move(bp, m, stderr);  /* Reports the error and aborts */
+                }
             }
 
             if (m == 0) {
@@ -734,7 +707,7 @@ int ccheck(int argc, char *argv[])
             /* Send move to engine if it's playing */
             if ((play_white && current_player == O) || (play_black && current_player == X)) {
                 fprintf(stderr, "DEBUG: Sending user move to engine\n");
-                if (send_move_to_engine(bp, m) < 0) {
+                if (send_move_to_engine(m, &path) < 0) {
                     fprintf(stderr, "Failed to send move to engine\n");
                     break;
                 }
@@ -747,53 +720,25 @@ int ccheck(int argc, char *argv[])
         int move_num_before = move_number(bp);
         Player move_player = current_player;
         
-        /* Update display BEFORE applying move (print_move needs pre-move board state) */
+        /* Update display BEFORE applying move */
         /* In tournament mode, update display for both computer and user moves (user moves come from stdin, not display) */
         /* In non-tournament mode, only update display for computer moves (user moves from display already know about it) */
         if (use_display && display_out) {
             if (is_computer_turn || tournament_mode) {
                 fprintf(stderr, "DEBUG: Updating display with move (before applying)\n");
-                /* Create a copy of the board for print_move (it needs pre-move board state) */
-                Board *temp_bp = newbd();
-                copybd(bp, temp_bp);
-                if (send_move_to_display(temp_bp, m) < 0) {
+                if (send_move_to_display(m, &path) < 0) {
                     fprintf(stderr, "DEBUG: Failed to update display, but continuing\n");
                     /* Continue even if display update fails */
                 }
-                /* Note: We can't easily free temp_bp, but it's just for printing */
             } else {
                 fprintf(stderr, "DEBUG: Skipping display update for user move (display already knows)\n");
             }
         }
         
-        /* Write to transcript BEFORE applying move (print_move needs pre-move board state) */
+        /* Write to transcript BEFORE applying move */
         if (transcript_file) {
-            /* Capture what print_move outputs and strip player prefix if present */
-            char move_buffer[256] = {0};
-            FILE *capture_stream = fmemopen(move_buffer, sizeof(move_buffer) - 1, "w");
-            if (capture_stream) {
-                print_move(bp, m, capture_stream);
-                fclose(capture_stream);
-            } else {
-                /* Fallback: write directly if fmemopen fails */
-                int transcript_move_num = (move_num_before / 2) + 1;
-                if (move_player == X) {
-                    fprintf(transcript_file, "%d. white:", transcript_move_num);
-                } else {
-                    fprintf(transcript_file, "%d. ... black:", transcript_move_num);
-                }
-                print_move(bp, m, transcript_file);
-                fprintf(transcript_file, "\n");
-                fflush(transcript_file);
-                goto skip_transcript_write;
-            }
-
-            /* Strip player prefix (e.g., "black:" or "white:") if present */
-            char *move_str = move_buffer;
-            char *colon = strchr(move_buffer, ':');
-            if (colon && (strncmp(move_buffer, "black:", 6) == 0 || strncmp(move_buffer, "white:", 6) == 0)) {
-                move_str = colon + 1;  /* Skip past the colon */
-            }
+            char move_buffer[MOVE_TEXT];
+            sprint_move_with_path(m, &path, move_buffer);
 
             /* Write formatted move to transcript */
             /* Move numbers: move_number increments after each move, so we need to calculate the move pair number */
@@ -806,11 +751,9 @@ int ccheck(int argc, char *argv[])
                 /* Black move: format is "N. ... black:MOVE" where N is same as white's move number */
                 fprintf(transcript_file, "%d. ... black:", transcript_move_num);
             }
-            fprintf(transcript_file, "%s", move_str);  /* Write only the move notation, not the player prefix */
-            fprintf(transcript_file, "\n");
+            fprintf(transcript_file, "%s\n", strchr(move_buffer, ':') + 1);  /* Write only the move notation, not the player prefix */
             fflush(transcript_file);
         }
-        skip_transcript_write:;
         
         /* Apply move to board */
         apply(bp, m);
@@ -849,6 +792,7 @@ int ccheck(int argc, char *argv[])
     if (engine_in) fclose(engine_in);
     if (engine_out) fclose(engine_out);
     if (transcript_file) fclose(transcript_file);
+    freebd(bp);
 
     return EXIT_SUCCESS;
 }
@@ -16,7 +16,6 @@
  #include <stdlib.h>
  #include <unistd.h>
  #include <signal.h>
- #include <setjmp.h>
  #include <time.h>
  #include <sys/time.h>
  #include <sys/select.h>
@@ -24,6 +23,7 @@
  #include <errno.h>
  
  #include "ccheck.h"
+ #include "board.h"
  #include "debug.h"
  
 /* Global variables (declared in ccheck.h, defined elsewhere) */
@@ -41,22 +41,16 @@ extern int otime;
 /* Signal handling */
 static volatile sig_atomic_t sighup_received = 0;
 static volatile sig_atomic_t sigalrm_received = 0;
-static sigjmp_buf search_jmpbuf;
-static int search_jmpbuf_valid = 0;
 
  /* Signal handler */
  static void engine_signal_handler(int sig)
  {
 	 if (sig == SIGHUP) {
 		 sighup_received = 1;
-		 if (search_jmpbuf_valid) {
-			 siglongjmp(search_jmpbuf, 1);
-		 }
+		 stop_search = 1;
 	 } else if (sig == SIGALRM) {
 		 sigalrm_received = 1;
-		 if (search_jmpbuf_valid) {
-			 siglongjmp(search_jmpbuf, 1);
-		 }
+		 stop_search = 1;
 	 }
  }
  
@@ -78,6 +72,49 @@ static int search_jmpbuf_valid = 0;
 	 }
  }
  
+/*
+ * Half-width of the first aspiration window: a little less than the value
+ * of one step of progress.
+ */
+#define ASPIRATION 64
+
+/*
+ * Search to the current depth.  If a score from an earlier iteration is
+ * known, the search starts with a narrow window around it, which is widened
+ * on the side on which the score falls outside, doubling each time, until
+ * the score is inside.
+ */
+static int aspiration_search(Board *bp, Move *stack, int guess, int have_guess)
+{
+	 int width = ASPIRATION;
+	 int score;
+
+	 if (have_guess) {
+		 window_alpha = guess - width > -MAXEVAL ? guess - width : -MAXEVAL;
+		 window_beta = guess + width < MAXEVAL ? guess + width : MAXEVAL;
+	 } else {
+		 window_alpha = -MAXEVAL;
+		 window_beta = MAXEVAL;
+	 }
+	 while (1) {
+		 score = search_window(bp, stack, window_alpha, window_beta);
+		 if (stop_search)
+			 return score;
+		 if (score <= window_alpha && window_alpha > -MAXEVAL) {
+			 width *= 2;
+			 window_alpha = score - width > -MAXEVAL ? score - width : -MAXEVAL;
+		 } else if (score >= window_beta && window_beta < MAXEVAL) {
+			 width *= 2;
+			 window_beta = score + width < MAXEVAL ? score + width : MAXEVAL;
+		 } else {
+			 break;
+		 }
+		 researches++;
+	 }
+	 window_score = score;
+	 return score;
+}
+
 void engine(Board *bp)
 {
 	 if (bp == NULL) {
@@ -90,12 +127,36 @@ void engine(Board *bp)
 	 setbuf(stdout, NULL);
 	 setbuf(stderr, NULL);
 
-	 /* Create a working copy of the board for searching */
-	 Board *search_bp = newbd();
-	 copybd(bp, search_bp);
-
+	 /*
+	  * Searches run directly on bp: a search that is interrupted by a signal
+	  * unwinds the board to the position at which it started.  The move lists
+	  * of every ply live in one move stack, allocated once.
+	  */
+	 Move *move_stack = malloc(MOVESTACK * sizeof(Move));
+	 if (move_stack == NULL) {
+		 fprintf(stderr, "ERROR: Engine: cannot allocate move stack!\n");
+		 abort();
+	 }
+	 if (tt_init(tt_megabytes) < 0) {
+		 fprintf(stderr, "ERROR: Engine: cannot allocate %d MB transposition table!\n", tt_megabytes);
+		 abort();
+	 }
+	 if (smp_init(search_threads) < 0) {
+		 fprintf(stderr, "ERROR: Engine: cannot set up %d search threads!\n", search_threads);
+		 abort();
+	 }
+	 if (split_init(search_procs) < 0) {
+		 fprintf(stderr, "ERROR: Engine: cannot set up %d search processes!\n", search_procs);
+		 abort();
+	 }
 	 int current_depth = 1;
 	 int best_depth = 0;
+	 /*
+	  * Scores of the searches to each depth up to best_depth.  Scores swing
+	  * with the side that moves last, so each iteration is aimed at the score
+	  * of the one two plies shallower.
+	  */
+	 int scores[MAXPLY + 1] = { 0 };
 	 int searching_on_opponent_time = 0;
 	 int first_wait = 1;  /* Flag to check stdin on first wait */
 	 while (1) {
@@ -108,13 +169,6 @@ void engine(Board *bp)
 						 break; /* Interrupted by SIGHUP */
 					 }
 
-					 search_jmpbuf_valid = 1;
-					 if (sigsetjmp(search_jmpbuf, 1) != 0) {
-						 /* Jumped here from signal handler */
-						 search_jmpbuf_valid = 0;
-						 break;
-					 }
-
 					 reset_stats();
 					 {
 						 time_t t;
@@ -127,11 +181,11 @@ void engine(Board *bp)
 						 fflush(stderr);
 					 }
 
-					 /* Restore working board to current state before each search */
-					 copybd(bp, search_bp);
-					 int score = bestmove(search_bp, player_to_move(search_bp), 0, principal_var, -MAXEVAL, MAXEVAL);
-
-					 search_jmpbuf_valid = 0;
+					 int score = aspiration_search(bp, move_stack, scores[depth > 2 ? depth - 2 : 0],
+													depth > 2 && best_depth >= depth - 2);
+					 if (stop_search) {
+						 break; /* Interrupted by a signal */
+					 }
 
 					 timings(depth);
 
@@ -142,6 +196,7 @@ void engine(Board *bp)
 					 }
 
 					 best_depth = depth;
+					 scores[depth] = score;
 
 					 /* Don't continue if position is won or lost */
 					 if (score == -(MAXEVAL-1) || score == MAXEVAL-1) {
@@ -178,6 +233,7 @@ void engine(Board *bp)
  
 		 if (sighup_received) {
 			 sighup_received = 0;
+			 stop_search = 0;
 			 searching_on_opponent_time = 0;
 
 			 char cmd[256];
@@ -250,13 +306,6 @@ void engine(Board *bp)
 						 }
 					 }
 
-					 search_jmpbuf_valid = 1;
-					 if (sigsetjmp(search_jmpbuf, 1) != 0) {
-						 /* Jumped here from signal handler */
-						 search_jmpbuf_valid = 0;
-						 break;
-					 }
-
 					 reset_stats();
 					 {
 						 time_t t;
@@ -269,11 +318,11 @@ void engine(Board *bp)
 						 fflush(stderr);
 					 }
 
-					 /* Restore working board to current state before each search */
-					 copybd(bp, search_bp);
-					 int score = bestmove(search_bp, player_to_move(search_bp), 0, principal_var, -MAXEVAL, MAXEVAL);
-
-					 search_jmpbuf_valid = 0;
+					 int score = aspiration_search(bp, move_stack, scores[depth > 2 ? depth - 2 : 0],
+													depth > 2 && best_depth >= depth - 2);
+					 if (stop_search) {
+						 break; /* Interrupted by a signal */
+					 }
 
 					 timings(depth);
 
@@ -284,6 +333,7 @@ void engine(Board *bp)
 					 }
 
 					 best_depth = depth;
+					 scores[depth] = score;
 
 					 /* Don't continue if position is won or lost */
 					 if (score == -(MAXEVAL-1) || score == MAXEVAL-1) {
@@ -339,16 +389,21 @@ void engine(Board *bp)
 				 /* Send best move if we have one */
 				 if (best_depth >= 1) {
 					 Move m = principal_var[0];
-					 /* Print move BEFORE applying it (print_move needs pre-move board state) */
-					 print_move(bp, m, stdout);
+					 /* Print move BEFORE applying it, with the hops recorded by the generator */
+					 Hoppath path;
+					 if (root_path(bp, m, &path) < 0) {
+						 print_move(bp, m, stdout);  /* Reports the error and aborts */
+					 }
+					 print_move_with_path(m, &path, stdout);
 					 printf("\n");
 					 fflush(stdout);
 
 					 /* Apply move to our board AFTER printing */
 					 apply(bp, m);
+					 smp_idle();
+					 tt_new_search();  /* Age the table for the new position */
+					 age_history();
 					 setclock(player_to_move(bp) == X ? O : X);
-					 /* Update search board copy */
-					 copybd(bp, search_bp);
 
 					 /* Reset search depth */
 					 current_depth = 1;
@@ -362,18 +417,24 @@ void engine(Board *bp)
 						 time(&t);
 						 searchtime = (int)t;
 					 }
-					 copybd(bp, search_bp);
-					 bestmove(search_bp, player_to_move(search_bp), 0, principal_var, -MAXEVAL, MAXEVAL);
+					 stop_search = 0;
+					 search(bp, move_stack);
 					 timings(1);
 					 best_depth = 1;
 					 
 					 Move m = principal_var[0];
-					 print_move(bp, m, stdout);
+					 Hoppath path;
+					 if (root_path(bp, m, &path) < 0) {
+						 print_move(bp, m, stdout);  /* Reports the error and aborts */
+					 }
+					 print_move_with_path(m, &path, stdout);
 					 printf("\n");
 					 fflush(stdout);
 					 apply(bp, m);
+					 smp_idle();
+					 tt_new_search();
+					 age_history();
 					 setclock(player_to_move(bp) == X ? O : X);
-					 copybd(bp, search_bp);
 					 current_depth = 1;
 					 best_depth = 0;
 				 }
@@ -388,9 +449,10 @@ void engine(Board *bp)
 					 if (m != 0) {
 						 /* Apply move to board */
 						 apply(bp, m);
+						 smp_idle();
+						 tt_new_search();
+						 age_history();
 						 setclock(player_to_move(bp) == X ? O : X);
-						 /* Update search board copy */
-						 copybd(bp, search_bp);
 
 						 /* If this matches our principal variation, keep it */
 						 if (best_depth >= 1 && principal_var[0] == m && best_depth > 1) {
@@ -400,6 +462,9 @@ void engine(Board *bp)
 							 }
 							 current_depth = best_depth - 1;
 							 best_depth = current_depth;
+							 for (int i = 1; i <= best_depth; i++) {
+								 scores[i] = -scores[i + 1];
+							 }
 						 } else {
 							 /* Reset search */
 							 current_depth = 1;
@@ -417,5 +482,7 @@ void engine(Board *bp)
 			 }
 		 }
 	 }
+
+	 free(move_stack);
  }
  
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*
+ * Static evaluator.
+ */
+
+#include "ccheck.h"
+#include "board.h"
+
+/*
+ * The score is dominated by the difference in the distance the two armies
+ * have travelled towards their goals, with closeness of the pieces to the
+ * long diagonal as a tie-breaker.
+ */
+int eval(Board *bp, Player p)
+{
+    int score;
+
+    nodes++;
+    if (bp->occ[X] == goal[X])
+        score = MAXEVAL - 1;
+    else if (bp->occ[O] == goal[O])
+        score = -(MAXEVAL - 1);
+    else
+        score = 100 * (bp->progress[X] - bp->progress[O])
+              + (bp->center[X] - bp->center[O]);
+
+    switch (p) {
+    case X:
+        return score;
+    case O:
+        return -score;
+    default:
+        return 0;
+    }
+}
+
+int game_over(Board *bp)
+{
+    if (bp->occ[X] == goal[X])
+        return 1;
+    if (bp->occ[O] == goal[O])
+        return -1;
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * Reading and checking moves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+int peekc;
+
+/*
+ * Read a point of the form "A1" through "I9".  On success the point is
+ * returned and peekc is set to 0.  Otherwise 0 is returned and peekc holds
+ * the offending character.
+ */
+int input_point(FILE *f)
+{
+    int r, c;
+
+    peekc = fgetc(f);
+    if (peekc < 'A' || peekc > 'I')
+        return 0;
+    r = peekc - 'A';
+    peekc = fgetc(f);
+    if (peekc < '1' || peekc > '9')
+        return 0;
+    c = peekc - '1';
+    peekc = 0;
+    return POINT(r, c);
+}
+
+Move read_move_with_path(FILE *str, Board *bp, Hoppath *path)
+{
+    int from, to;
+
+    while (1) {
+        do {
+            peekc = fgetc(str);
+        } while (peekc != ':' && peekc != '\n' && peekc != EOF);
+        if (peekc == EOF)
+            return 0;
+        if (peekc == '\n')
+            abort();
+        from = input_point(str);
+        if (peekc)
+            abort();
+        path->point[0] = from;
+        path->len = 1;
+        peekc = fgetc(str);
+        if (peekc != '-')
+            abort();
+        while (peekc == '-') {
+            to = input_point(str);
+            if (peekc || path->len == MAXPATH)
+                abort();
+            path->point[path->len++] = to;
+            peekc = fgetc(str);
+            if (peekc == '\n') {
+                peekc = 0;
+                Move m = MAKE_MOVE(bp->player, from, to);
+                if (!legal_move(m, bp))
+                    abort();
+                if (check_path(bp, m, path))
+                    return m;
+                /* Only the ends of a jump given: find the hops */
+                if (path->len > 2 || move_path(bp, m, path) < 0)
+                    abort();
+                return m;
+            }
+        }
+    }
+}
+
+Move read_move_from_pipe(FILE *str, Board *bp)
+{
+    Hoppath path;
+
+    return read_move_with_path(str, bp, &path);
+}
+
+Move read_move_interactive(Board *bp)
+{
+    Player p = bp->player;
+    int from, to;
+
+    while (1) {
+        fprintf(stdout, "Your move? ");
+        fflush(stdout);
+        from = input_point(stdin);
+        if (peekc)
+            goto syntax;
+        peekc = getchar();
+        if (peekc != '-') {
+            fprintf(stdout, "A move must consist of at least two points.\n");
+            goto flush;
+        }
+        while (peekc == '-') {
+            to = input_point(stdin);
+            if (peekc)
+                goto syntax;
+            peekc = getchar();
+            if (peekc == '\n') {
+                peekc = 0;
+                Move m = MAKE_MOVE(p, from, to);
+                if (legal_move(m, bp)) {
+                    print_move(bp, m, stdout);
+                    fputc('\n', stdout);
+                    fflush(stdout);
+                    return m;
+                }
+                fprintf(stderr, "Illegal move!\n");
+                goto flush;
+            }
+        }
+    syntax:
+        fprintf(stdout, "Eh?\n");
+    flush:
+        if (peekc == 0)
+            continue;
+        while (peekc != '\n') {
+            if (peekc == EOF) {
+                fprintf(stderr, "Unexpected EOF on interactive input.\n");
+                return 0;
+            }
+            peekc = getchar();
+        }
+    }
+}
+
+/*
+ * A move is checked directly against the board, without generating the
+ * other moves: a step by looking at the destination, a jump by a flood
+ * fill from the source that stops when the destination is reached.
+ */
+int legal_move(Move m, Board *bd)
+{
+    Player p = bd->player;
+    int fr = row_from(m), fc = col_from(m);
+    int tr = row_to(m), tc = col_to(m);
+
+    if ((m & ~0x1ffff) || (m & MOVE_PLAYER) != (p == O ? MOVE_PLAYER : 0))
+        return 0;
+    if (fr >= BDSIZE || fc >= BDSIZE || tr >= BDSIZE || tc >= BDSIZE)
+        return 0;
+    if (!(bd->occ[p] & BIT(SQUARE(fr, fc))))
+        return 0;
+    for (int d = 0; d < NDIRS; d++) {
+        if (fr + rdirect[d] == tr && fc + cdirect[d] == tc) {
+            Bitboard targets = empty_cells(bd) | (bd->occ[1 - p] & swapzone[p]);
+            return (targets & BIT(SQUARE(tr, tc))) != 0;
+        }
+    }
+    return jump_reaches(bd, SQUARE(fr, fc), SQUARE(tr, tc));
+}
+
+/* Parse a point from a string, advancing the string past it. */
+static int scan_point(const char **sp)
+{
+    const char *t = *sp;
+
+    if (t[0] < 'A' || t[0] > 'I' || t[1] < '1' || t[1] > '9')
+        return -1;
+    *sp = t + 2;
+    return POINT(t[0] - 'A', t[1] - '1');
+}
+
+/*
+ * Parse the move on one line, in the notation printed by print_move, for
+ * the player to move.  Only the source and the final destination are used.
+ * Returns 0 if the line is malformed.
+ */
+static Move scan_move(Board *bp, const char *t)
+{
+    int from, to;
+
+    while (*t == ' ' || *t == '\t')
+        t++;
+    if ((from = scan_point(&t)) < 0 || *t != '-')
+        return 0;
+    while (*t == '-') {
+        t++;
+        if ((to = scan_point(&t)) < 0)
+            return 0;
+    }
+    while (*t == ' ' || *t == '\t' || *t == '\r')
+        t++;
+    if (*t != '\n' && *t != '\0')
+        return 0;
+    return MAKE_MOVE(bp->player, from, to);
+}
+
+int replay_moves(Board *bp, const char *text, int max, Move *mv,
+                 char *notation, size_t size, const char **endp, int *why)
+{
+    char *np = notation;
+    int n = 0;
+    int stop = REPLAY_END;
+
+    while (*text) {
+        const char *eol = strchr(text, '\n');
+        const char *colon = memchr(text, ':', eol ? eol - text : strlen(text));
+        const char *next = eol ? eol + 1 : text + strlen(text);
+
+        if (colon == NULL) {
+            text = next;
+            continue;
+        }
+        if (n >= max) {
+            stop = REPLAY_LIMIT;
+            break;
+        }
+        Move m = scan_move(bp, colon + 1);
+        if (m == 0 || !legal_move(m, bp)) {
+            stop = REPLAY_ILLEGAL;
+            break;
+        }
+        if (notation != NULL) {
+            char buf[MOVE_TEXT];
+            int len = sprint_move(bp, m, buf);
+            if (len < 0) {
+                stop = REPLAY_ILLEGAL;
+                break;
+            }
+            if ((size_t)(np - notation) + len + 2 > size) {
+                stop = REPLAY_FULL;
+                break;
+            }
+            memcpy(np, buf, len);
+            np += len;
+            *np++ = '\n';
+        }
+        apply(bp, m);
+        if (mv != NULL)
+            mv[n] = m;
+        n++;
+        text = next;
+    }
+    if (notation != NULL && size > 0)
+        *np = '\0';
+    if (endp != NULL)
+        *endp = text;
+    if (why != NULL)
+        *why = stop;
+    return n;
+}
@@ -0,0 +1,359 @@
+/*
+ * Move generator.
+ */
+
+#include "ccheck.h"
+#include "board.h"
+#include "tables.h"
+
+_Thread_local Move resultlist[MAXMOVES];
+_Thread_local Move *resultp;
+
+_Thread_local long jumpgens, stepgens;
+_Thread_local long jumptot, steptot;
+
+/*
+ * Jumps are found as a breadth-first closure over the cells reachable by
+ * hopping: every cell is entered at most once, so a destination reachable
+ * by several different chains of hops is listed once, with the cell from
+ * which it was first reached as its predecessor.  There is no recursion.
+ * Neighbouring and landing squares come from the generated tables, in which
+ * off-board cells map to OFFBOARD; that square is never occupied and never
+ * open, so no bounds checks are needed.
+ */
+int jump_closure(Board *bp, int s, unsigned char *reached, unsigned char *pred)
+{
+    Bitboard occupied = bp->occ[X] | bp->occ[O];
+    Bitboard open = onboard & ~occupied;
+    int head = 0, tail = 0;
+    int cur = s;
+
+    while (1) {
+        for (int d = 0; d < NDIRS; d++) {
+            if (!(occupied & BIT(neighbor[cur][d])))
+                continue;
+            int land = landing[cur][d];
+            if (!(open & BIT(land)))
+                continue;
+            open &= ~BIT(land);
+            pred[land] = cur;
+            reached[tail++] = land;
+        }
+        if (head == tail)
+            return tail;
+        cur = reached[head++];
+    }
+}
+
+/* Generate the jumps from square s with destinations in the given set. */
+static int jumps_to(Board *bp, int s, Bitboard allowed, Move *out, int cap)
+{
+    unsigned char reached[BDSIZE * BDSIZE];
+    unsigned char pred[NSQUARES];
+    int from = SQ_POINT(s);
+    int count = jump_closure(bp, s, reached, pred);
+    int n = 0;
+
+    for (int i = 0; i < count && n < cap; i++) {
+        if (allowed & BIT(reached[i]))
+            out[n++] = MAKE_MOVE(bp->player, from, SQ_POINT(reached[i]));
+    }
+    return n;
+}
+
+/* Square index increment in each direction, for set-wise shifts. */
+static const int delta[NDIRS] = { 1, 1 - BBWIDTH, -BBWIDTH, -1, BBWIDTH - 1, BBWIDTH };
+
+static inline Bitboard shift(Bitboard b, int n)
+{
+    return n >= 0 ? b << n : b >> -n;
+}
+
+/* Generate the steps from square s with destinations in the given set. */
+static int steps_to(Board *bp, int s, Bitboard allowed, Move *out, int cap)
+{
+    Player p = bp->player;
+    Bitboard targets = allowed
+                     & (empty_cells(bp) | (bp->occ[1 - p] & swapzone[p]));
+    int from = SQ_POINT(s);
+    int n = 0;
+
+    for (int d = 0; d < NDIRS; d++) {
+        int to = neighbor[s][d];
+        if ((targets & BIT(to)) && n < cap)
+            out[n++] = MAKE_MOVE(p, from, SQ_POINT(to));
+    }
+    return n;
+}
+
+/*
+ * The steps of all the pieces of the player to move are found a direction
+ * at a time, by shifting the whole set of pieces one cell in that direction
+ * and masking with the open targets; targets[d] is left holding the
+ * destinations of the steps in direction d.  The cost is the same whatever
+ * the position.  The guard column and row keep shifted pieces from
+ * wrapping around the board.
+ */
+static void step_targets(Board *bp, Bitboard targets[NDIRS])
+{
+    Player p = bp->player;
+    Bitboard open = empty_cells(bp) | (bp->occ[1 - p] & swapzone[p]);
+
+    for (int d = 0; d < NDIRS; d++)
+        targets[d] = shift(bp->occ[p], delta[d]) & open;
+}
+
+/* List the steps whose destinations are in targets[d] for the directions in dirs. */
+static int serialize_steps(Player p, Bitboard targets[NDIRS], unsigned dirs,
+                           Move *out, int cap)
+{
+    int n = 0;
+
+    for (int d = 0; d < NDIRS; d++) {
+        if (!(dirs & (1 << d)))
+            continue;
+        while (targets[d] && n < cap) {
+            int to = bb_pop(&targets[d]);
+            out[n++] = MAKE_MOVE(p, SQ_POINT(to - delta[d]), SQ_POINT(to));
+        }
+    }
+    return n;
+}
+
+/*
+ * Directions in which a step loses no ground for each player: those that
+ * do not decrease row + column for X (E, NE, SW, S), and those that do not
+ * increase it for O (NE, N, W, SW).
+ */
+static const unsigned forward_dirs[2] = { 0x33, 0x1e };
+
+/* Cells that lose no ground for player p relative to square s. */
+static inline Bitboard forward_of(Player p, int s)
+{
+    return ahead[p][SQ_ROW(s) + SQ_COL(s)];
+}
+
+int gen_jumps_from(Board *bp, int s, Move *out, int cap)
+{
+    return jumps_to(bp, s, onboard, out, cap);
+}
+
+/*
+ * The cells reachable by hopping are flooded a whole set at a time: each
+ * round moves the frontier by one hop in all six directions at once.  The
+ * guard column and row keep shifted cells from wrapping around the board,
+ * and the search stops as soon as the target is reached.
+ */
+int jump_reaches(Board *bp, int s, int t)
+{
+    Bitboard occupied = bp->occ[X] | bp->occ[O];
+    Bitboard open = onboard & ~occupied;
+    Bitboard seen = BIT(s), frontier = BIT(s);
+
+    if (!(open & BIT(t)))
+        return 0;
+    while (frontier) {
+        Bitboard next = 0;
+        for (int d = 0; d < NDIRS; d++)
+            next |= shift(shift(frontier, delta[d]) & occupied, delta[d]);
+        frontier = next & open & ~seen;
+        if (frontier & BIT(t))
+            return 1;
+        seen |= frontier;
+    }
+    return 0;
+}
+
+int gen_steps_from(Board *bp, int s, Move *out, int cap)
+{
+    return steps_to(bp, s, onboard, out, cap);
+}
+
+int gen_jumps(Board *bp, Move *out, int cap)
+{
+    unsigned char *pieces = bp->pieces[bp->player];
+    int n = 0;
+
+    jumpgens++;
+    for (int i = 0; i < NPIECES; i++)
+        n += gen_jumps_from(bp, pieces[i], out + n, cap - n);
+    jumptot += n;
+    return n;
+}
+
+int gen_steps(Board *bp, Move *out, int cap)
+{
+    Bitboard targets[NDIRS];
+    int n;
+
+    stepgens++;
+    step_targets(bp, targets);
+    n = serialize_steps(bp->player, targets, (1 << NDIRS) - 1, out, cap);
+    steptot += n;
+    return n;
+}
+
+int gen_moves(Board *bp, Move *out, int cap)
+{
+    unsigned char *pieces = bp->pieces[bp->player];
+    int n = 0;
+
+    for (int i = 0; i < NPIECES; i++) {
+        n += gen_jumps_from(bp, pieces[i], out + n, cap - n);
+        n += gen_steps_from(bp, pieces[i], out + n, cap - n);
+    }
+    return n;
+}
+
+int gen_forward_jumps(Board *bp, Move *out, int cap)
+{
+    Player p = bp->player;
+    unsigned char *pieces = bp->pieces[p];
+    int n = 0;
+
+    jumpgens++;
+    for (int i = 0; i < NPIECES; i++)
+        n += jumps_to(bp, pieces[i], forward_of(p, pieces[i]), out + n, cap - n);
+    jumptot += n;
+    return n;
+}
+
+int gen_forward_steps(Board *bp, Move *out, int cap)
+{
+    Player p = bp->player;
+    Bitboard targets[NDIRS];
+    int n;
+
+    stepgens++;
+    step_targets(bp, targets);
+    n = serialize_steps(p, targets, forward_dirs[p], out, cap);
+    steptot += n;
+    return n;
+}
+
+/*
+ * Fill in the path of a jump from square s to square t, by following the
+ * predecessor map of the jump closure back from t.
+ */
+static void trace_path(int s, int t, const unsigned char *pred, Hoppath *path)
+{
+    int sq[MAXPATH];
+    int n = 0;
+
+    for (int cur = t; cur != s; cur = pred[cur])
+        sq[n++] = cur;
+    sq[n++] = s;
+    path->len = n;
+    for (int i = 0; i < n; i++)
+        path->point[i] = SQ_POINT(sq[n - 1 - i]);
+}
+
+int gen_jumps_with_paths(Board *bp, Move *out, Hoppath *paths, int cap)
+{
+    unsigned char reached[BDSIZE * BDSIZE];
+    unsigned char pred[NSQUARES];
+    unsigned char *pieces = bp->pieces[bp->player];
+    int n = 0;
+
+    for (int i = 0; i < NPIECES; i++) {
+        int s = pieces[i];
+        int count = jump_closure(bp, s, reached, pred);
+        for (int j = 0; j < count && n < cap; j++) {
+            out[n] = MAKE_MOVE(bp->player, SQ_POINT(s), SQ_POINT(reached[j]));
+            trace_path(s, reached[j], pred, &paths[n]);
+            n++;
+        }
+    }
+    return n;
+}
+
+int move_path(Board *bp, Move m, Hoppath *path)
+{
+    unsigned char reached[BDSIZE * BDSIZE];
+    unsigned char pred[NSQUARES];
+    int fr = row_from(m), fc = col_from(m);
+    int tr = row_to(m), tc = col_to(m);
+    int s = SQUARE(fr, fc), t = SQUARE(tr, tc);
+
+    path->point[0] = POINT(fr, fc);
+    path->len = 1;
+    if (IS_PASS(m))
+        return 0;
+    for (int d = 0; d < NDIRS; d++) {
+        if (neighbor[s][d] == t) {
+            path->point[path->len++] = POINT(tr, tc);
+            return 0;
+        }
+    }
+    int count = jump_closure(bp, s, reached, pred);
+    for (int i = 0; i < count; i++) {
+        if (reached[i] == t) {
+            trace_path(s, t, pred, path);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int check_path(Board *bp, Move m, const Hoppath *path)
+{
+    Bitboard occupied = bp->occ[X] | bp->occ[O];
+    int n = path->len;
+
+    if (n < 2 || n > MAXPATH || path->point[0] != POINT(row_from(m), col_from(m))
+        || path->point[n - 1] != POINT(row_to(m), col_to(m)))
+        return 0;
+    for (int i = 0; i < n; i++) {
+        if ((path->point[i] >> 4) >= BDSIZE || (path->point[i] & 0xf) >= BDSIZE)
+            return 0;
+    }
+    for (int i = 1; i < n; i++) {
+        int s = SQUARE(path->point[i - 1] >> 4, path->point[i - 1] & 0xf);
+        int t = SQUARE(path->point[i] >> 4, path->point[i] & 0xf);
+        int ok = 0;
+        for (int d = 0; d < NDIRS; d++) {
+            if (n == 2 && neighbor[s][d] == t)
+                ok = 1;
+            if (landing[s][d] == t && (occupied & BIT(neighbor[s][d]))
+                && !(occupied & BIT(t)))
+                ok = 1;
+        }
+        if (!ok)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * X advances by increasing row + column and O by decreasing it, so the
+ * armies have passed once X's rearmost piece is further along than O's.
+ */
+int in_contact(Board *bp)
+{
+    int xmin = NDIAGS, omax = -1;
+
+    for (int i = 0; i < NPIECES; i++) {
+        int xs = bp->pieces[X][i], os = bp->pieces[O][i];
+        int x = SQ_ROW(xs) + SQ_COL(xs), o = SQ_ROW(os) + SQ_COL(os);
+        if (x < xmin)
+            xmin = x;
+        if (o > omax)
+            omax = o;
+    }
+    return xmin <= omax;
+}
+
+void jump_moves(Board *bp)
+{
+    resultp = resultlist + gen_jumps(bp, resultlist, MAXMOVES);
+}
+
+void step_moves(Board *bp)
+{
+    resultp = resultlist + gen_steps(bp, resultlist, MAXMOVES);
+}
+
+void moves(Board *bp)
+{
+    resultp = resultlist + gen_moves(bp, resultlist, MAXMOVES);
+}
@@ -0,0 +1,55 @@
+/*
+ * Packed encoding of positions.
+ */
+
+#include "ccheck.h"
+#include "board.h"
+
+#define ROWMASK ((1 << BDSIZE) - 1)
+#define NCELLS (BDSIZE * BDSIZE)
+
+void encode_position(Board *bp, Poscode *pc)
+{
+    Bitboard occupied = bp->occ[X] | bp->occ[O];
+    Bitboard code = 0;
+    int n = NCELLS;
+
+    /* Squeeze out the guard column of each row. */
+    for (int r = 0; r < BDSIZE; r++)
+        code |= ((occupied >> SQUARE(r, 0)) & ROWMASK) << (BDSIZE * r);
+    while (occupied) {
+        int s = bb_pop(&occupied);
+        if (bp->occ[O] & BIT(s))
+            code |= BIT(n);
+        n++;
+    }
+    if (bp->player == O)
+        code |= BIT(n);
+
+    for (int i = 0; i < POSCODE_BYTES; i++)
+        pc->bytes[i] = (unsigned char)(code >> (8 * i));
+}
+
+Board *decode_position(const Poscode *pc, Board *bp)
+{
+    Bitboard code = 0, cells = 0, xs = 0, os = 0;
+    int n = NCELLS;
+
+    for (int i = POSCODE_BYTES - 1; i >= 0; i--)
+        code = (code << 8) | pc->bytes[i];
+    for (int r = 0; r < BDSIZE; r++)
+        cells |= ((code >> (BDSIZE * r)) & ROWMASK) << SQUARE(r, 0);
+    if (bb_count(cells) != 2 * NPIECES)
+        return NULL;
+    while (cells) {
+        int s = bb_pop(&cells);
+        if (code & BIT(n))
+            os |= BIT(s);
+        else
+            xs |= BIT(s);
+        n++;
+    }
+    if (bb_count(xs) != NPIECES || (code >> (n + 1)) != 0)
+        return NULL;
+    return setbd(bp, xs, os, (code & BIT(n)) ? O : X);
+}
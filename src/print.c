@@ -0,0 +1,132 @@
+/*
+ * Printing moves and boards.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+void print_point(int pt, FILE *s)
+{
+    if (((pt >> 4) & 0xf) >= BDSIZE || (pt & 0xf) >= BDSIZE)
+        abort();
+    fprintf(s, "%c%c", ((pt >> 4) & 0xf) + 'A', (pt & 0xf) + '1');
+}
+
+/* Append a point in the form "A1" through "I9" to a string. */
+static char *put_point(char *t, int r, int c)
+{
+    *t++ = 'A' + r;
+    *t++ = '1' + c;
+    return t;
+}
+
+int sprint_move_with_path(Move m, const Hoppath *path, char *buf)
+{
+    char *t = buf;
+
+    t += sprintf(t, (m & MOVE_PLAYER) ? "black:" : "white:");
+    if (IS_PASS(m)) {
+        t += sprintf(t, "pass");
+        return t - buf;
+    }
+    for (int i = 0; i < path->len; i++) {
+        if (i > 0)
+            *t++ = '-';
+        t = put_point(t, path->point[i] >> 4, path->point[i] & 0xf);
+    }
+    *t = '\0';
+    return t - buf;
+}
+
+void print_move_with_path(Move m, const Hoppath *path, FILE *s)
+{
+    char buf[MOVE_TEXT];
+
+    sprint_move_with_path(m, path, buf);
+    fputs(buf, s);
+}
+
+/*
+ * A jump is printed with all its intermediate hops.  These are recovered
+ * from the predecessor map of the jump closure from the source, following
+ * it back from the destination.
+ */
+int sprint_move(Board *bp, Move m, char *buf)
+{
+    int fr = row_from(m), fc = col_from(m);
+    Hoppath path;
+
+    if (fr >= BDSIZE || fc >= BDSIZE
+        || row_to(m) >= BDSIZE || col_to(m) >= BDSIZE)
+        abort();
+    if (move_path(bp, m, &path) < 0) {
+        char *t = buf + sprintf(buf, (m & MOVE_PLAYER) ? "black:" : "white:");
+        put_point(t, fr, fc)[0] = '\0';
+        return -1;
+    }
+    return sprint_move_with_path(m, &path, buf);
+}
+
+void print_move(Board *bp, Move m, FILE *s)
+{
+    char buf[MOVE_TEXT];
+
+    int n = sprint_move(bp, m, buf);
+
+    fputs(buf, s);
+    if (n >= 0)
+        return;
+    fprintf(s, "...Error in print_move...\n");
+    print_bd(bp, s);
+    while (bp->hp > 0) {
+        undo(bp);
+        print_bd(bp, s);
+    }
+    abort();
+}
+
+void print_pvar(Board *bp, int d)
+{
+    if (d == depth) {
+        fprintf(stderr, " (%d)\n", eval(bp, bp->player));
+        return;
+    }
+    print_move(bp, principal_var[d], stderr);
+    fputc(' ', stderr);
+    apply(bp, principal_var[d]);
+    print_pvar(bp, d + 1);
+    undo(bp);
+}
+
+void print_bd(Board *bp, FILE *s)
+{
+    for (int r = BDSIZE - 1; r >= 0; r--) {
+        for (int i = 0; i < r; i++)
+            fputc(' ', s);
+        fputc('A' + r, s);
+        for (int c = 0; c < BDSIZE; c++) {
+            Bitboard b = BIT(SQUARE(r, c));
+            if (bp->occ[X] & b)
+                fprintf(s, " %c", 'W');
+            else if (bp->occ[O] & b)
+                fprintf(s, " %c", 'B');
+            else
+                fprintf(s, " -");
+        }
+        fputc('\n', s);
+    }
+    fprintf(s, " 1 2 3 4 5 6 7 8 9\n");
+    switch (bp->player) {
+    case X:
+        fprintf(s, "White to move, ");
+        break;
+    case O:
+        fprintf(s, "Black to move, ");
+        break;
+    }
+    fprintf(s, "Score = %d/%d (%d)\n\n", bp->progress[X], bp->progress[O],
+            eval(bp, bp->player));
+}
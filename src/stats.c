@@ -0,0 +1,62 @@
+/*
+ * Search statistics and time control.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+int starttime;
+int searchtime;
+int movetime;
+int xtime;
+int otime;
+_Thread_local int nodes;
+int avgtime;
+int window_alpha, window_beta;
+int window_score;
+int researches;
+
+/* Initial estimates (seconds) of the time taken to search to each depth. */
+int times[MAXPLY + 2] = { 0, 0, 1, 5, 30, 300, 3000, 300000, 3000000, 30000000 };
+
+void reset_stats()
+{
+    nodes = 0;
+    jumpgens = stepgens = 0;
+    jumptot = steptot = 0;
+    tt_probes = tt_hits = tt_cutoffs = 0;
+    researches = 0;
+    searchtime = time(NULL);
+}
+
+void print_stats()
+{
+    fprintf(stderr, "Nodes: %d, Time: %ld(%d/%d), MG: %ld/%ld, TM: %ld/%ld, TT: %d/%d/%d, "
+            "AW: %d [%d,%d]/%d\n",
+            nodes, time(NULL) - searchtime, xtime, otime,
+            jumpgens, stepgens, jumptot, steptot,
+            tt_probes, tt_hits, tt_cutoffs,
+            window_score, window_alpha, window_beta, researches);
+}
+
+void timings(int d)
+{
+    int t = time(NULL) - searchtime;
+
+    times[d] = (times[d] + t) / 2;
+    times[d + 1] = (3 * times[d + 1] + 10 * t) / 4;
+}
+
+void setclock(Player p)
+{
+    int t = time(NULL) - movetime;
+
+    if (p == X)
+        xtime += t;
+    else
+        otime += t;
+    movetime = time(NULL);
+}
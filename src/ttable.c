@@ -0,0 +1,176 @@
+/*
+ * Transposition table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "ccheck.h"
+#include "board.h"
+
+int tt_megabytes = TT_DEFAULT_MB;
+_Thread_local int tt_probes, tt_hits, tt_cutoffs;
+
+/*
+ * The table is an array of buckets, each the size of a cache line, so that
+ * a probe touches one line.  The first TT_DEEP entries of a bucket are
+ * kept for the deepest searches: a new result replaces one left over from
+ * an earlier search if there is one, and otherwise the shallowest of them,
+ * but only if it is at least as deep.  Anything else goes in the last
+ * entry, which is always replaced, so that recent results are kept too.
+ * The low bits of the key select the bucket.
+ *
+ * The table is shared by all the search threads, without locks.  Each
+ * slot holds an entry packed into one word, and a check word which is the
+ * key XORed with the entry.  A slot torn by two threads writing it at once
+ * no longer checks against the key of either, and is simply not found.
+ */
+#define TT_WAYS 4
+#define TT_DEEP (TT_WAYS - 1)
+
+typedef struct {
+    _Atomic uint64_t check;               // Key XOR data
+    _Atomic uint64_t data;                // Packed entry
+} Ttslot;
+
+typedef struct {
+    Ttslot slot[TT_WAYS];
+} __attribute__((aligned(64))) Ttbucket;
+
+/* Fields of a packed entry. */
+#define MOVE_BITS 18
+#define SCORE_BITS 18
+#define SCORE_OFFSET (1 << (SCORE_BITS - 1))
+#define DEPTH_SHIFT (MOVE_BITS + SCORE_BITS)
+#define BOUND_SHIFT (DEPTH_SHIFT + 4)
+#define AGE_SHIFT (BOUND_SHIFT + 2)
+
+static Ttbucket *table;
+static uint64_t mask;                     // Number of buckets, less one
+static unsigned char generation;          // Count of searches, modulo 256
+
+static inline uint64_t pack(const Ttentry *e)
+{
+    return (uint64_t)e->move
+         | (uint64_t)(e->score + SCORE_OFFSET) << MOVE_BITS
+         | (uint64_t)e->depth << DEPTH_SHIFT
+         | (uint64_t)e->bound << BOUND_SHIFT
+         | (uint64_t)e->age << AGE_SHIFT;
+}
+
+static inline void unpack(uint64_t w, Ttentry *e)
+{
+    e->move = w & ((1 << MOVE_BITS) - 1);
+    e->score = (int)((w >> MOVE_BITS) & ((1 << SCORE_BITS) - 1)) - SCORE_OFFSET;
+    e->depth = (w >> DEPTH_SHIFT) & 0xf;
+    e->bound = (w >> BOUND_SHIFT) & 0x3;
+    e->age = (w >> AGE_SHIFT) & 0xff;
+}
+
+/* Read a slot, giving the bound TT_NONE if it does not hold the key. */
+static void read_slot(Ttslot *s, uint64_t key, Ttentry *e)
+{
+    uint64_t data = atomic_load_explicit(&s->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&s->check, memory_order_relaxed);
+
+    unpack(data, e);
+    if ((check ^ data) != key)
+        e->bound = TT_NONE;
+}
+
+int tt_init(int megabytes)
+{
+    uint64_t n = 1;
+
+    free(table);
+    table = NULL;
+    mask = 0;
+    if (megabytes <= 0)
+        return 0;
+    while (2 * n * sizeof(Ttbucket) <= (uint64_t)megabytes << 20)
+        n *= 2;
+    if ((table = aligned_alloc(sizeof(Ttbucket), n * sizeof(Ttbucket))) == NULL)
+        return -1;
+    mask = n - 1;
+    tt_clear();
+    return 0;
+}
+
+void tt_clear(void)
+{
+    if (table == NULL)
+        return;
+    for (uint64_t i = 0; i <= mask; i++) {
+        for (int w = 0; w < TT_WAYS; w++) {
+            atomic_store_explicit(&table[i].slot[w].data, 0, memory_order_relaxed);
+            atomic_store_explicit(&table[i].slot[w].check, 0, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void tt_new_search(void)
+{
+    generation++;
+}
+
+int tt_probe(uint64_t key, Ttentry *e)
+{
+    if (table == NULL)
+        return 0;
+    tt_probes++;
+    Ttslot *s = table[key & mask].slot;
+    for (int w = 0; w < TT_WAYS; w++) {
+        read_slot(&s[w], key, e);
+        if (e->bound != TT_NONE) {
+            tt_hits++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void tt_store(uint64_t key, int depth, int bound, int score, Move best)
+{
+    if (table == NULL)
+        return;
+    Ttslot *s = table[key & mask].slot;
+    Ttslot *slot = NULL;
+    Ttentry e, low;
+
+    for (int w = 0; w < TT_WAYS; w++) {
+        read_slot(&s[w], key, &e);
+        if (e.bound != TT_NONE) {
+            if (depth < e.depth && e.age == generation)
+                return;
+            /* Keep the old best move if this search found none */
+            if (best == MOVE_END)
+                best = e.move;
+            slot = &s[w];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        slot = &s[0];
+        unpack(atomic_load_explicit(&s[0].data, memory_order_relaxed), &low);
+        for (int w = 1; w < TT_DEEP; w++) {
+            unpack(atomic_load_explicit(&s[w].data, memory_order_relaxed), &e);
+            /* Prefer an entry from an earlier search, then the shallowest */
+            int stale = e.age != generation;
+            int low_stale = low.age != generation;
+            if (stale > low_stale
+                || (stale == low_stale && e.depth < low.depth)) {
+                slot = &s[w];
+                low = e;
+            }
+        }
+        if (depth < low.depth && low.age == generation)
+            slot = &s[TT_DEEP];
+    }
+    e = (Ttentry){ .move = best, .score = score, .depth = depth,
+                   .bound = bound, .age = generation };
+    uint64_t data = pack(&e);
+    atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+    atomic_store_explicit(&slot->check, key ^ data, memory_order_relaxed);
+}